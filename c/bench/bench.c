@@ -0,0 +1,144 @@
+#include "argparse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define OPTIONS 200
+#define REPEAT 5
+#define COUNT 1000000
+
+// Maximum tolerated growth of the time per argument between the smallest and largest input
+#define LINEAR_TOLERANCE 4.0
+
+enum scenario { LONG_FLAGS = 0, SHORT_BUNDLES, FLAG_LIST, POSITIONAL };
+
+static char const *scenario_names[] = {"long-flags", "short-bundles", "flag-list", "positional"};
+
+static char names[OPTIONS][16];
+static char longs[OPTIONS][24];
+static char values[COUNT][24];
+static char bundle[17];
+
+static struct flag *list;
+static struct arg *files;
+
+/*!
+ * Creates a parser with the given amount of long flags, short flags are the bytes 1..OPTIONS
+ */
+static struct parser *make_parser(int options) {
+    struct parser *parser = parser_init("bench", "Benchmark of the argument parsing.", NULL);
+    for (int i = 0; i < options; ++i) {
+        parser_add_flag(parser, (char)(i + 1), names[i], "Generated flag.");
+    }
+    list = parser_add_flag_list(parser, (char)(options + 1), "list", "VALUE", "List of values.", SET_NONE);
+    files = parser_add_arg_list(parser, "FILES", "List of files.");
+    return parser;
+}
+
+/*!
+ * Fills argv for the scenario with n generated arguments, returns argc
+ */
+static int make_args(char const **argv, enum scenario s, int n) {
+    int argc = 0;
+    argv[argc++] = "bench";
+    if (s == FLAG_LIST) {
+        argv[argc++] = "--list";
+    }
+    for (int i = 0; i < n; ++i) {
+        switch (s) {
+        case LONG_FLAGS:
+            argv[argc++] = longs[(i * 31) % OPTIONS];
+            break;
+        case SHORT_BUNDLES:
+            argv[argc++] = bundle;
+            break;
+        default:
+            argv[argc++] = values[i];
+            break;
+        }
+    }
+    if (s != POSITIONAL) {
+        argv[argc++] = "--";
+        argv[argc++] = "file";
+    }
+    return argc;
+}
+
+static double now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/*!
+ * Returns the best time in nanoseconds per argument of multiple runs. Fails if the lists don't provide all values.
+ */
+static double run(char const *const *argv, int argc, enum scenario s, size_t n) {
+    size_t list_cnt = s == FLAG_LIST ? n : 0;
+    size_t files_cnt = s == POSITIONAL ? n : 1;
+
+    double best = -1;
+    for (int r = 0; r < REPEAT; ++r) {
+        struct parser *parser = make_parser(OPTIONS);
+
+        double start = now_ns();
+        int res = parser_parse_args(parser, argv, argc);
+        double stop = now_ns();
+
+        if (res != 0) {
+            fprintf(stderr, "Parsing of %d arguments failed.\n", argc);
+            exit(1);
+        }
+        if (flag_list_count(list) != list_cnt || arg_list_count(files) != files_cnt ||
+            arg_list_get(files)[files_cnt - 1] != argv[argc - 1] ||
+            (list_cnt > 0 && flag_list_get(list)[list_cnt - 1] != argv[list_cnt + 1])) {
+            fprintf(stderr, "Values of %d arguments are truncated.\n", argc);
+            exit(1);
+        }
+
+        parser_deinit(parser);
+        if (best < 0 || stop - start < best) {
+            best = stop - start;
+        }
+    }
+    return best / argc;
+}
+
+int main() {
+    for (int i = 0; i < OPTIONS; ++i) {
+        snprintf(names[i], sizeof(names[i]), "option-%d", i);
+        snprintf(longs[i], sizeof(longs[i]), "--%s", names[i]);
+    }
+    for (int i = 0; i < COUNT; ++i) {
+        snprintf(values[i], sizeof(values[i]), "/data/shard/%d", i);
+    }
+
+    // Combined short flags with 15 flags each
+    bundle[0] = '-';
+    for (int i = 1; i < 16; ++i) {
+        bundle[i] = (char)(i * 7 % OPTIONS + 1);
+    }
+    bundle[16] = '\0';
+
+    int failed = 0;
+    char const **argv = malloc(sizeof(char const *) * (COUNT + 4));
+    for (int s = LONG_FLAGS; s <= POSITIONAL; ++s) {
+        double base = -1;
+        for (int n = 10000; n <= COUNT; n *= 10) {
+            int argc = make_args(argv, s, n);
+            double per_arg = run(argv, argc, s, n);
+            fprintf(stdout, "%s %d args: %.2f ns/arg\n", scenario_names[s], n, per_arg);
+
+            if (base < 0) {
+                base = per_arg;
+            } else if (per_arg > base * LINEAR_TOLERANCE) {
+                fprintf(stderr, "%s parse time grows faster than linear.\n", scenario_names[s]);
+                failed = 1;
+            }
+        }
+    }
+    free(argv);
+    return failed;
+}
@@ -0,0 +1,271 @@
+#include "argparse.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Short flags are single bytes, thus the number of flags per command is limited
+#define MAX_OPTIONS 250
+#define MAX_DEPTH 8
+#define MAX_ARGC 1000000
+#define REPEAT 5
+
+// Small inputs are parsed repeatedly until at least this many arguments are processed per measurement
+#define MIN_WORK 1000000
+
+enum format { FORMAT_CSV = 0, FORMAT_JSON };
+
+static char names[MAX_OPTIONS][16];
+static char longs[MAX_OPTIONS][24];
+static char levels[MAX_DEPTH][16];
+static char values[MAX_ARGC][24];
+static char bundle[17];
+
+static FILE *out;
+static enum format format;
+static int rows;
+
+/*!
+ * Creates a parser with a chain of `depth` subcommands. Each command has `options` flags, the last one additionally
+ * accepts a flag list and a list of files.
+ */
+static struct parser *make_parser(int options, int depth) {
+    struct parser *parser = parser_init("bench", "Benchmark of the argument parsing.", NULL);
+    struct command *cmd = NULL;
+
+    for (int d = 0; d <= depth; ++d) {
+        if (d > 0) {
+            cmd = d == 1 ? parser_add_command(parser, levels[0], "Generated command.", NULL)
+                         : command_add_subcommand(cmd, levels[d - 1], "Generated command.", NULL);
+        }
+        for (int i = 0; i < options; ++i) {
+            if (cmd == NULL) {
+                parser_add_flag(parser, (char)(i + 1), names[i], "Generated flag.");
+            } else {
+                command_add_flag(cmd, (char)(i + 1), names[i], "Generated flag.", SET_NONE);
+            }
+        }
+    }
+
+    if (cmd == NULL) {
+        parser_add_flag_list(parser, (char)(MAX_OPTIONS + 1), "list", "VALUE", "List of values.", SET_NONE);
+        parser_add_arg_list(parser, "FILES", "List of files.");
+    } else {
+        command_add_flag_list(cmd, (char)(MAX_OPTIONS + 1), "list", "VALUE", "List of values.", SET_NONE);
+        command_add_arg_list(cmd, "FILES", "List of files.");
+    }
+    return parser;
+}
+
+static double now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void report(char const *scenario, char const *parameter, long value, int argc, long iterations, double ns) {
+    if (format == FORMAT_JSON) {
+        fprintf(out,
+                "%s\n    {\"scenario\": \"%s\", \"parameter\": \"%s\", \"value\": %ld, \"argc\": %d, "
+                "\"iterations\": %ld, \"ns_per_parse\": %.1f, \"ns_per_arg\": %.3f}",
+                rows == 0 ? "" : ",", scenario, parameter, value, argc, iterations, ns, ns / argc);
+    } else {
+        fprintf(out, "argparse-c,%s,%s,%ld,%d,%ld,%.1f,%.3f\n", scenario, parameter, value, argc, iterations, ns,
+                ns / argc);
+    }
+    rows += 1;
+}
+
+/*!
+ * Returns the best time in nanoseconds per parse of multiple runs. The parser is reset before each parse.
+ */
+static double measure(struct parser *parser, char const *const *argv, int argc, long iterations, int expect) {
+    double best = -1;
+    for (int r = 0; r < REPEAT; ++r) {
+        double start = now_ns();
+        for (long i = 0; i < iterations; ++i) {
+            parser_reset(parser);
+            if (parser_parse_args(parser, argv, argc) != expect) {
+                fprintf(stderr, "Parsing of %d arguments failed.\n", argc);
+                exit(1);
+            }
+        }
+        double stop = now_ns();
+        if (best < 0 || stop - start < best) {
+            best = stop - start;
+        }
+    }
+    return best / iterations;
+}
+
+static long iterations_for(int argc) { return argc >= MIN_WORK ? 1 : MIN_WORK / argc; }
+
+static void run(char const *scenario, char const *parameter, long value, struct parser *parser,
+                char const *const *argv, int argc) {
+    long iterations = iterations_for(argc);
+    report(scenario, parameter, value, argc, iterations, measure(parser, argv, argc, iterations, 0));
+}
+
+/*!
+ * Appends the terminating file argument, returns argc
+ */
+static int finish_args(char const **argv, int argc) {
+    argv[argc++] = "--";
+    argv[argc++] = "file";
+    return argc;
+}
+
+static void bench_argc(char const **argv) {
+    struct parser *parser = make_parser(16, 0);
+    for (int n = 10; n <= MAX_ARGC; n *= 10) {
+        int argc = 0;
+        argv[argc++] = "bench";
+        for (int i = 0; i < n; ++i) {
+            argv[argc++] = longs[i % 16];
+        }
+        run("long-flags", "argc", n, parser, argv, finish_args(argv, argc));
+    }
+    parser_deinit(parser);
+}
+
+static void bench_options(char const **argv) {
+    int const counts[] = {1, 10, 50, 100, MAX_OPTIONS};
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+        struct parser *parser = make_parser(counts[c], 0);
+        int argc = 0;
+        argv[argc++] = "bench";
+        for (int i = 0; i < 1000; ++i) {
+            argv[argc++] = longs[(i * 7) % counts[c]];
+        }
+        run("lookup", "options", counts[c], parser, argv, finish_args(argv, argc));
+        parser_deinit(parser);
+    }
+}
+
+static void bench_depth(char const **argv) {
+    for (int d = 1; d <= MAX_DEPTH; ++d) {
+        struct parser *parser = make_parser(16, d);
+        int argc = 0;
+        argv[argc++] = "bench";
+        for (int i = 0; i < d; ++i) {
+            argv[argc++] = levels[i];
+        }
+        argv[argc++] = longs[0];
+        run("subcommands", "depth", d, parser, argv, finish_args(argv, argc));
+        parser_deinit(parser);
+    }
+}
+
+static void bench_bundles(char const **argv) {
+    struct parser *parser = make_parser(MAX_OPTIONS, 0);
+    for (int n = 10; n <= MAX_ARGC; n *= 10) {
+        int argc = 0;
+        argv[argc++] = "bench";
+        for (int i = 0; i < n; ++i) {
+            argv[argc++] = bundle;
+        }
+        run("short-bundles", "argc", n, parser, argv, finish_args(argv, argc));
+    }
+    parser_deinit(parser);
+}
+
+static void bench_lists(char const **argv) {
+    struct parser *parser = make_parser(16, 0);
+    for (int n = 10; n <= MAX_ARGC; n *= 10) {
+        int argc = 0;
+        argv[argc++] = "bench";
+        argv[argc++] = "--list";
+        for (int i = 0; i < n; ++i) {
+            argv[argc++] = values[i];
+        }
+        run("flag-list", "argc", n, parser, argv, finish_args(argv, argc));
+    }
+    parser_deinit(parser);
+}
+
+static void bench_help() {
+    char const *argv[] = {"bench", "-h"};
+    int const counts[] = {1, 10, 50, 100, MAX_OPTIONS};
+
+    // Help is written to stdout, discard it during the measurement
+    int saved = dup(STDOUT_FILENO);
+    int null = open("/dev/null", O_WRONLY);
+
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+        struct parser *parser = make_parser(counts[c], 0);
+        long iterations = 1000;
+
+        fflush(stdout);
+        dup2(null, STDOUT_FILENO);
+        double ns = measure(parser, argv, 2, iterations, 1);
+        fflush(stdout);
+        dup2(saved, STDOUT_FILENO);
+
+        report("help", "options", counts[c], 2, iterations, ns);
+        parser_deinit(parser);
+    }
+    close(null);
+    close(saved);
+}
+
+int main(int argc, char **argv) {
+    struct parser *cli =
+        parser_init(argv[0], "Benchmark suite of argparse-c. Results are written as CSV or JSON.", NULL);
+    struct flag *fmt = parser_add_flag_value(cli, 'f', "format", "FORMAT", "Output format, csv or json.", SET_NONE);
+    struct flag *output = parser_add_flag_value(cli, 'o', "output", "FILE", "Write results to file.", SET_NONE);
+    if (parser_parse_args(cli, (char const *const *)argv, argc) != 0) {
+        parser_deinit(cli);
+        return 1;
+    }
+    format = flag_value_exists(fmt) && strcmp(flag_value_get(fmt), "json") == 0 ? FORMAT_JSON : FORMAT_CSV;
+    out = flag_value_exists(output) ? fopen(flag_value_get(output), "w") : stdout;
+    parser_deinit(cli);
+    if (out == NULL) {
+        fprintf(stderr, "Unable to open output file.\n");
+        return 1;
+    }
+
+    for (int i = 0; i < MAX_OPTIONS; ++i) {
+        snprintf(names[i], sizeof(names[i]), "option-%d", i);
+        snprintf(longs[i], sizeof(longs[i]), "--%s", names[i]);
+    }
+    for (int i = 0; i < MAX_DEPTH; ++i) {
+        snprintf(levels[i], sizeof(levels[i]), "level-%d", i + 1);
+    }
+    for (int i = 0; i < MAX_ARGC; ++i) {
+        snprintf(values[i], sizeof(values[i]), "/data/shard/%d", i);
+    }
+
+    // Combined short flags with 15 flags each
+    bundle[0] = '-';
+    for (int i = 1; i < 16; ++i) {
+        bundle[i] = (char)(i * 7 % MAX_OPTIONS + 1);
+    }
+    bundle[16] = '\0';
+
+    if (format == FORMAT_JSON) {
+        fprintf(out, "{\n  \"library\": \"argparse-c\",\n  \"results\": [");
+    } else {
+        fprintf(out, "library,scenario,parameter,value,argc,iterations,ns_per_parse,ns_per_arg\n");
+    }
+
+    char const **args = malloc(sizeof(char const *) * (MAX_ARGC + MAX_DEPTH + 4));
+    bench_argc(args);
+    bench_options(args);
+    bench_depth(args);
+    bench_bundles(args);
+    bench_lists(args);
+    bench_help();
+    free(args);
+
+    if (format == FORMAT_JSON) {
+        fprintf(out, "\n  ]\n}\n");
+    }
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
@@ -22,42 +22,257 @@
  * SOFTWARE.
  *********************************************************************************************************************/
 
+#include <assert.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef ARGPARSE_STATS
+#include <time.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ARGPARSE_POSIX
+#endif
+
 #include "argparse.h"
 
 /*********************************************************************************************************************
- * struct flag
+ * stats
  *********************************************************************************************************************/
 
-struct __attribute__((packed)) flag {
-    char _short;
-    unsigned int _count : 8;
-    unsigned int _flags : 8;
-    char const *_long;
+#ifdef ARGPARSE_STATS
+static unsigned long long stats_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+}
+
+#define STATS_BEGIN(name) unsigned long long name = stats_now()
+#define STATS_END(stats, field, name) ((stats)->field += stats_now() - (name))
+#define STATS_ADD(stats, field, n) ((stats)->field += (n))
+#else
+// Instrumentation is compiled out, the statistics stay zero. The target is still consumed to keep parameters used.
+#define STATS_BEGIN(name)
+#define STATS_END(stats, field, name) ((void)(stats))
+#define STATS_ADD(stats, field, n) ((void)(stats))
+#endif
+
+/*********************************************************************************************************************
+ * arena
+ *********************************************************************************************************************/
+
+#define ARENA_ALIGN _Alignof(max_align_t)
+#define ARENA_BLOCK_SIZE 4096
+
+/*!
+ * Memory block of the arena, the usable memory directly follows the header
+ */
+struct block {
+    struct block *_next;
+    size_t _size;
+    size_t _used;
+    unsigned int _owned : 1;
+};
+
+/*!
+ * Bump allocator for all nodes of a parser, everything is released at once by arena_free(..)
+ */
+struct arena {
+    struct block *_blocks;
+    size_t _block_size;
+    size_t _bytes;
+    void *_scratch; /*!< Reused buffer, see arena_scratch(..) */
+    size_t _scratch_size;
+};
+
+static size_t align_up(size_t size) { return (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1); }
+
+static void block_init(struct block *ctx, size_t size, int owned) {
+    ctx->_next = NULL;
+    ctx->_size = size;
+    ctx->_used = align_up(sizeof(struct block));
+    ctx->_owned = owned;
+}
+
+/*!
+ * Initializes the arena either with heap allocated blocks of the given size or with a caller-owned buffer. The arena
+ * never allocates from heap if a buffer is provided.
+ */
+static int arena_init(struct arena *ctx, void *buffer, size_t size) {
+    ctx->_blocks = NULL;
+    ctx->_block_size = size > 0 ? size : ARENA_BLOCK_SIZE;
+    ctx->_bytes = 0;
+    ctx->_scratch = NULL;
+    ctx->_scratch_size = 0;
+
+    if (buffer != NULL) {
+        size_t offset = align_up((uintptr_t)buffer) - (uintptr_t)buffer;
+        if (size < offset + align_up(sizeof(struct block))) {
+            return -1;
+        }
+        ctx->_blocks = (struct block *)((char *)buffer + offset);
+        ctx->_block_size = 0;
+        // Aligned end, the scratch buffer is taken from the end of the block
+        block_init(ctx->_blocks, (size - offset) & ~(ARENA_ALIGN - 1), 0);
+    }
+    return 0;
+}
+
+static void *arena_alloc(struct arena *ctx, size_t size) {
+    size = align_up(size);
+
+    struct block *b = ctx->_blocks;
+    if (b == NULL || b->_size - b->_used < size) {
+        if (ctx->_block_size == 0) {
+            return NULL;
+        }
+
+        size_t b_size = align_up(sizeof(struct block)) + size;
+        b_size = b_size < ctx->_block_size ? ctx->_block_size : b_size;
+        b = malloc(b_size);
+        if (b == NULL) {
+            return NULL;
+        }
+        block_init(b, b_size, 1);
+
+        if (ctx->_blocks != NULL && b_size > ctx->_block_size) {
+            // Oversized allocations get a dedicated block, keep filling the current one
+            b->_next = ctx->_blocks->_next;
+            ctx->_blocks->_next = b;
+        } else {
+            b->_next = ctx->_blocks;
+            ctx->_blocks = b;
+        }
+    }
+
+    void *ptr = (char *)b + b->_used;
+    b->_used += size;
+    STATS_ADD(ctx, _bytes, size);
+    return ptr;
+}
+
+/*!
+ * Returns a buffer of at least the given size that is reused by every call, its content is not preserved. With heap
+ * blocks it's a dedicated allocation replaced on growth, a caller-owned buffer gives up its end instead. Thus growing
+ * the buffer never leaves the outgrown one behind in the arena.
+ */
+static void *arena_scratch(struct arena *ctx, size_t size) {
+    size = align_up(size);
+    if (size <= ctx->_scratch_size) {
+        return ctx->_scratch;
+    }
+
+    if (ctx->_block_size == 0) {
+        struct block *b = ctx->_blocks;
+        size_t grow = size - ctx->_scratch_size;
+        if (b->_size - b->_used < grow) {
+            return NULL;
+        }
+        b->_size -= grow;
+        ctx->_scratch = (char *)b + b->_size;
+    } else {
+        void *scratch = malloc(size);
+        if (scratch == NULL) {
+            return NULL;
+        }
+        free(ctx->_scratch);
+        ctx->_scratch = scratch;
+    }
+    STATS_ADD(ctx, _bytes, size - ctx->_scratch_size);
+    ctx->_scratch_size = size;
+    return ctx->_scratch;
+}
+
+static void arena_free(struct arena *ctx) {
+    if (ctx->_block_size != 0) {
+        free(ctx->_scratch);
+    }
+    ctx->_scratch = NULL;
+    ctx->_scratch_size = 0;
+
+    struct block *b = ctx->_blocks;
+    while (b != NULL) {
+        struct block *next = b->_next;
+        if (b->_owned) {
+            free(b);
+        }
+        b = next;
+    }
+    ctx->_blocks = NULL;
+}
+
+/*********************************************************************************************************************
+ * struct doc
+ *********************************************************************************************************************/
+
+#define DOC_BLOCK 16
+
+/*!
+ * Texts of a flag or arg, kept apart from the nodes since only used for help and error messages
+ */
+struct doc {
     char const *_placeholder;
     char const *_desc;
+    size_t _width; /*!< Length of the names shown in the first column */
+};
+
+/*********************************************************************************************************************
+ * struct slot
+ *********************************************************************************************************************/
+
+/*!
+ * Values of a flag or arg gathered by a parse run. Each node embeds the slot used by parser_parse_args(..), a
+ * struct parse_result has its own slots indexed by the id of the node.
+ */
+struct slot {
+    size_t _count;
     char const *const *_values;
+};
+
+static void slot_clear(struct slot *ctx) {
+    ctx->_count = 0;
+    ctx->_values = NULL;
+}
+
+/*********************************************************************************************************************
+ * struct flag
+ *********************************************************************************************************************/
+
+enum flag_kind { FLAG_KIND_FLAG = 0, FLAG_KIND_VALUE, FLAG_KIND_LIST };
 
-    int (*takes)();
-    int (*parse)(struct flag *ctx, char const *const *, int);
+struct flag {
+    char _short;
+    unsigned char _kind;
+    unsigned char _flags;
+    size_t _id;
+    size_t _len;
+    struct slot _slot;
+    char const *_long;
+    struct flag *_next; /*!< Next flag of the command in order of addition */
+
+    struct doc const *_doc;
 };
 
-static void flag_init(struct flag *ctx, char const flag, char const *const l_flag, char const *const placeholder,
-                      char const *const desc, unsigned int flags, int (*takes)(),
-                      int (*parse)(struct flag *, char const *const *, int)) {
+static void flag_init(struct flag *ctx, size_t id, char const flag, char const *const l_flag, struct doc const *doc,
+                      unsigned int flags, unsigned int kind) {
     ctx->_short = flag;
-    ctx->_long = l_flag;
+    ctx->_kind = kind;
     ctx->_flags = flags;
-    ctx->_placeholder = placeholder;
-    ctx->_desc = desc;
-    ctx->_count = 0;
-    ctx->_values = NULL;
-    ctx->takes = takes;
-    ctx->parse = parse;
+    ctx->_id = id;
+    ctx->_len = strlen(l_flag);
+    slot_clear(&ctx->_slot);
+    ctx->_long = l_flag;
+    ctx->_next = NULL;
+    ctx->_doc = doc;
 }
 
 /*********************************************************************************************************************
@@ -66,22 +281,22 @@ static void flag_init(struct flag *ctx, char const flag, char const *const l_fla
 
 static int flag_takes() { return 0; }
 
-static int flag_parse(struct flag *ctx, char const *const *argv, int argc) {
+static int flag_parse(struct slot *ctx, char const *const *argv, int argc) {
     ctx->_count += 1;
     return 0;
 }
 
-int flag_count(struct flag *flag) {
+size_t flag_count(struct flag *flag) {
     if (flag != NULL) {
-        return flag->_count;
+        return flag->_slot._count;
     } else {
-        return -1;
+        return 0;
     }
 }
 
 int flag_set(struct flag *flag) {
     if (flag != NULL) {
-        return flag->_count > 0 ? 1 : 0;
+        return flag->_slot._count > 0 ? 1 : 0;
     } else {
         return -1;
     }
@@ -93,7 +308,7 @@ int flag_set(struct flag *flag) {
 
 static int flag_value_takes() { return 1; }
 
-static int flag_value_parse(struct flag *ctx, char const *const *argv, int argc) {
+static int flag_value_parse(struct slot *ctx, char const *const *argv, int argc) {
     if (argc < 1 || ctx->_values != NULL || ctx->_count != 0) {
         // Fail if option already parsed
         return -1;
@@ -105,7 +320,7 @@ static int flag_value_parse(struct flag *ctx, char const *const *argv, int argc)
 
 int flag_value_exists(struct flag *value) {
     if (value != NULL) {
-        return value->_values != NULL;
+        return value->_slot._values != NULL;
     } else {
         return -1;
     }
@@ -113,7 +328,7 @@ int flag_value_exists(struct flag *value) {
 
 char const *flag_value_get(struct flag *value) {
     if (value != NULL) {
-        return *value->_values;
+        return *value->_slot._values;
     } else {
         return NULL;
     }
@@ -125,7 +340,7 @@ char const *flag_value_get(struct flag *value) {
 
 static int flag_list_takes() { return 1; }
 
-static int flag_list_parse(struct flag *ctx, char const *const *argv, int argc) {
+static int flag_list_parse(struct slot *ctx, char const *const *argv, int argc) {
     if (argc < 1 || ctx->_values != NULL || ctx->_count != 0) {
         // Fail if option already parsed
         return -1;
@@ -137,51 +352,77 @@ static int flag_list_parse(struct flag *ctx, char const *const *argv, int argc)
 
 int flag_list_exists(struct flag *list) {
     if (list != NULL) {
-        return list->_values != NULL && list->_count > 0 ? 1 : 0;
+        return list->_slot._values != NULL && list->_slot._count > 0 ? 1 : 0;
     } else {
         return -1;
     }
 }
 
-int flag_list_count(struct flag *list) {
+size_t flag_list_count(struct flag *list) {
     if (list != NULL) {
-        return list->_count;
+        return list->_slot._count;
     } else {
-        return -1;
+        return 0;
     }
 }
 
 char const *const *flag_list_get(struct flag *list) {
     if (list != NULL) {
-        return list->_values;
+        return list->_slot._values;
     } else {
         return NULL;
     }
 }
 
+/*********************************************************************************************************************
+ * flag dispatch
+ *********************************************************************************************************************/
+
+static int flag_kind_takes(unsigned int kind) {
+    switch (kind) {
+    case FLAG_KIND_VALUE:
+        return flag_value_takes();
+    case FLAG_KIND_LIST:
+        return flag_list_takes();
+    default:
+        return flag_takes();
+    }
+}
+
+static int flag_kind_parse(unsigned int kind, struct slot *slot, char const *const *argv, int argc) {
+    switch (kind) {
+    case FLAG_KIND_VALUE:
+        return flag_value_parse(slot, argv, argc);
+    case FLAG_KIND_LIST:
+        return flag_list_parse(slot, argv, argc);
+    default:
+        return flag_parse(slot, argv, argc);
+    }
+}
+
 /*********************************************************************************************************************
  * struct arg
  *********************************************************************************************************************/
 
-struct __attribute__((packed)) arg {
-    char const *_name;
-    char const *_desc;
+enum arg_kind { ARG_KIND_VALUE = 0, ARG_KIND_LIST, ARG_KIND_STREAM };
 
-    unsigned int _count : 8;
-    char const *const *_values;
+struct arg {
+    unsigned char _kind;
+    size_t _id;
+    struct slot _slot;
+    char const *_name;
+    struct arg *_next; /*!< Next arg of the command in order of addition */
 
-    int (*takes)();
-    int (*parse)(struct arg *, char const *const *argv, int argc);
+    struct doc const *_doc;
 };
 
-static void arg_init(struct arg *ctx, char const *const name, char const *const desc, int (*takes)(),
-                     int (*parse)(struct arg *, char const *const *, int)) {
+static void arg_init(struct arg *ctx, size_t id, char const *const name, struct doc const *doc, unsigned int kind) {
+    ctx->_kind = kind;
+    ctx->_id = id;
+    slot_clear(&ctx->_slot);
     ctx->_name = name;
-    ctx->_desc = desc;
-    ctx->_count = 0;
-    ctx->_values = NULL;
-    ctx->takes = takes;
-    ctx->parse = parse;
+    ctx->_next = NULL;
+    ctx->_doc = doc;
 }
 
 /*********************************************************************************************************************
@@ -190,7 +431,7 @@ static void arg_init(struct arg *ctx, char const *const name, char const *const
 
 static int arg_value_takes() { return 1; }
 
-static int arg_value_parse(struct arg *ctx, char const *const *argv, int argc) {
+static int arg_value_parse(struct slot *ctx, char const *const *argv, int argc) {
     if (argc < 1 || ctx->_values != NULL || ctx->_count != 0) {
         // Fail if required already parsed
         return -1;
@@ -202,7 +443,7 @@ static int arg_value_parse(struct arg *ctx, char const *const *argv, int argc) {
 
 char const *const arg_value_get(struct arg *value) {
     if (value != NULL) {
-        return *value->_values;
+        return *value->_slot._values;
     } else {
         return NULL;
     }
@@ -214,228 +455,417 @@ char const *const arg_value_get(struct arg *value) {
 
 static int arg_list_takes() { return 2; }
 
-static int arg_list_parse(struct arg *ctx, char const *const *argv, int argc) {
+static int arg_list_parse(struct slot *ctx, char const *const *argv, int argc) {
     if (argc < 1 || ctx->_values != NULL || ctx->_count != 0) {
         // Fail if required already parsed
         return -1;
     }
     ctx->_values = &argv[0];
     ctx->_count = argc;
-    return 1;
+    return argc;
 }
 
-int arg_list_count(struct arg *list) {
+size_t arg_list_count(struct arg *list) {
     if (list != NULL) {
-        return list->_count;
+        return list->_slot._count;
     } else {
-        return -1;
+        return 0;
     }
 }
 
 char const *const *arg_list_get(struct arg *list) {
     if (list != NULL) {
-        return list->_values;
+        return list->_slot._values;
     } else {
         return NULL;
     }
 }
 
+/*********************************************************************************************************************
+ * arg_stream
+ *********************************************************************************************************************/
+
+#define ARG_STREAM_BUFFER 65536
+
+/*!
+ * Reads up to n bytes, returns the number of bytes read, 0 at the end of the input and -1 on failure
+ */
+static long arg_stream_input(int fd, char *buffer, size_t n) {
+#ifdef ARGPARSE_POSIX
+    // Partial reads deliver the values written to a pipe so far without waiting for a full buffer
+    for (;;) {
+        ssize_t cnt = read(fd, buffer, n);
+        if (cnt >= 0 || errno != EINTR) {
+            return (long)cnt;
+        }
+    }
+#else
+    // Without POSIX only stdin is supported
+    if (fd != 0) {
+        return -1;
+    }
+    size_t cnt = fread(buffer, 1, n, stdin);
+    return cnt == 0 && ferror(stdin) ? -1 : (long)cnt;
+#endif
+}
+
+/*!
+ * Delivers the values given on the commandline. If none or only "-" is given, the values are read from the input
+ * instead, each terminated by the delimiter. The buffer is reused for all values, thus its size limits each value.
+ */
+static int arg_stream_deliver(struct arg const *ctx, struct slot const *slot, int fd, char delim, arg_stream_fn fn,
+                              void *data) {
+    if (slot->_count > 1 || (slot->_count == 1 && strcmp(slot->_values[0], "-") != 0)) {
+        for (size_t i = 0; i < slot->_count; ++i) {
+            int res = fn(slot->_values[i], data);
+            if (res != 0) {
+                return res;
+            }
+        }
+        return 0;
+    }
+
+    // One byte more than read at once, thus the last value can always be terminated
+    char *buffer = malloc(ARG_STREAM_BUFFER + 1);
+    if (buffer == NULL) {
+        return -1;
+    }
+    size_t begin = 0;
+    size_t end = 0;
+    int eof = 0;
+    int res = 0;
+    while (res == 0) {
+        char *next = memchr(buffer + begin, delim, end - begin);
+        if (next == NULL && eof) {
+            // Last value without delimiter
+            if (begin < end) {
+                buffer[end] = '\0';
+                res = fn(buffer + begin, data);
+            }
+            break;
+        }
+        if (next == NULL) {
+            memmove(buffer, buffer + begin, end - begin);
+            end -= begin;
+            begin = 0;
+            if (end == ARG_STREAM_BUFFER) {
+                fprintf(stderr, "Value of '%s' exceeds %d bytes.\n", ctx->_name, ARG_STREAM_BUFFER);
+                res = -1;
+                break;
+            }
+            long cnt = arg_stream_input(fd, buffer + end, ARG_STREAM_BUFFER - end);
+            if (cnt < 0) {
+                fprintf(stderr, "Unable to read values of '%s'.\n", ctx->_name);
+                res = -1;
+                break;
+            }
+            eof = cnt == 0;
+            end += (size_t)cnt;
+            continue;
+        }
+
+        // Empty values are skipped, e.g. of blank lines
+        *next = '\0';
+        if (next > buffer + begin) {
+            res = fn(buffer + begin, data);
+        }
+        begin = (size_t)(next - buffer) + 1;
+    }
+    free(buffer);
+    return res;
+}
+
+int arg_stream_read(struct arg *stream, int fd, char delim, arg_stream_fn fn, void *data) {
+    if (stream == NULL || stream->_kind != ARG_KIND_STREAM || fn == NULL) {
+        return -1;
+    }
+    return arg_stream_deliver(stream, &stream->_slot, fd, delim, fn, data);
+}
+
+/*********************************************************************************************************************
+ * arg dispatch
+ *********************************************************************************************************************/
+
+static int arg_kind_takes(unsigned int kind) {
+    switch (kind) {
+    case ARG_KIND_LIST:
+    case ARG_KIND_STREAM:
+        return arg_list_takes();
+    default:
+        return arg_value_takes();
+    }
+}
+
+static int arg_kind_parse(unsigned int kind, struct slot *slot, char const *const *argv, int argc) {
+    switch (kind) {
+    case ARG_KIND_LIST:
+    case ARG_KIND_STREAM:
+        return arg_list_parse(slot, argv, argc);
+    default:
+        return arg_value_parse(slot, argv, argc);
+    }
+}
+
+/*********************************************************************************************************************
+ * spec
+ *********************************************************************************************************************/
+
+/*!
+ * Shared by all nodes of a parser, provides the memory and the ids of the nodes
+ */
+struct spec {
+    struct arena _arena;
+    size_t _flags;
+    size_t _args;
+    size_t _commands;
+    size_t _columns;       /*!< Line width of help messages, 0 if detected */
+    unsigned char _changed; /*!< Nodes were added since the last parser_finalize(..) */
+    struct doc *_docs;      /*!< Unused part of the current block of docs */
+    size_t _docs_free;
+    struct parser_stats _stats;
+};
+
+static void spec_init(struct spec *ctx, struct arena const *arena) {
+    ctx->_arena = *arena;
+    ctx->_flags = 0;
+    ctx->_args = 0;
+    ctx->_commands = 0;
+    ctx->_columns = 0;
+    ctx->_changed = 1;
+    ctx->_docs = NULL;
+    ctx->_docs_free = 0;
+    memset(&ctx->_stats, 0, sizeof(ctx->_stats));
+}
+
 /*********************************************************************************************************************
  * command
  *********************************************************************************************************************/
 
-struct flag_item;
-struct arg_item;
-struct command_item;
+/*!
+ * Rendered help message of a command, built on first use and valid as long as the line width is unchanged. It's kept
+ * apart from the command, thus parser_parse_args(..) can fill it while the parse path only reads the command. The
+ * buffer is reused if the command is modified or the width changes.
+ */
+struct help {
+    char *_data;
+    size_t _len;
+    size_t _cap;
+    size_t _columns; /*!< Line width of the rendered message, 0 if outdated */
+};
+
+/*!
+ * Copy of a flag as read by the parse loop, stored contiguously per command by command_finalize(..)
+ */
+struct flag_entry {
+    char _short;
+    unsigned char _kind;
+    unsigned char _flags;
+    size_t _id;
+    size_t _len;
+    char const *_long;
+    struct flag const *_node; /*!< Only used for error messages */
+};
+
+/*!
+ * Copy of an arg as read by the parse loop, stored contiguously per command by command_finalize(..)
+ */
+struct arg_entry {
+    unsigned char _kind;
+    size_t _id;
+};
+
+/*!
+ * Name of a subcommand as compared by the parse loop, stored contiguously per command by command_finalize(..)
+ */
+struct command_entry {
+    size_t _len;
+    char const *_name;
+    struct command const *_command;
+};
 
-struct __attribute__((packed)) command {
+struct command {
+    unsigned char _set;
+    size_t _id;
+    size_t _len;
     char const *_name;
+
+    // Built by command_finalize(..), the parse loop only reads these. Lookup of the flags: 256 slots for short flags
+    // followed by the open-addressing table of long flags.
+    struct flag_entry const **_index;
+    size_t _mask;
+    struct flag_entry *_flags;
+    struct arg_entry *_args;
+    struct command_entry *_subcommands;
+    size_t _flag_cnt;
+    size_t _arg_cnt;
+    size_t _subcommand_cnt;
+
+    // Nodes in order of addition, linked by their _next
+    struct flag *_optionals;
+    struct flag *_optionals_last;
+    struct arg *_requires;
+    struct arg *_requires_last;
+    struct command *_commands;
+    struct command *_commands_last;
+    struct command *_next;
+    struct command *_parent;
+    struct spec *_spec;
+
+    // Only used for help messages
     char const *_desc;
     char const *_footer;
-    unsigned int _set : 1;
 
-    struct command *_parent;
-    struct flag_item *_optionals;
-    struct arg_item *_requires;
-    struct command_item *_commands;
+    struct help *_help;
 };
 
-static void command_init(struct command *ctx, char const *const name, char const *const desc, char const *const footer,
-                         struct command *parent) {
-    ctx->_name = name;
-    ctx->_desc = desc;
-    ctx->_footer = footer;
+static void command_init(struct command *ctx, struct spec *spec, char const *const name, char const *const desc,
+                         char const *const footer, struct command *parent, struct help *help) {
     ctx->_set = 0;
-    ctx->_parent = parent;
+    ctx->_id = spec->_commands++;
+    ctx->_len = strlen(name);
+    ctx->_name = name;
+    ctx->_index = NULL;
+    ctx->_mask = 0;
+    ctx->_flags = NULL;
+    ctx->_args = NULL;
+    ctx->_subcommands = NULL;
+    ctx->_flag_cnt = 0;
+    ctx->_arg_cnt = 0;
+    ctx->_subcommand_cnt = 0;
     ctx->_optionals = NULL;
+    ctx->_optionals_last = NULL;
     ctx->_requires = NULL;
+    ctx->_requires_last = NULL;
     ctx->_commands = NULL;
+    ctx->_commands_last = NULL;
+    ctx->_next = NULL;
+    ctx->_parent = parent;
+    ctx->_spec = spec;
+    ctx->_desc = desc;
+    ctx->_footer = footer;
+    ctx->_help = help;
+    memset(help, 0, sizeof(struct help));
 }
 
 int command_is_set(struct command *ctx) { return ctx->_set; }
 
 /*********************************************************************************************************************
- * flag_item
+ * command flags
  *********************************************************************************************************************/
 
-struct __attribute__((packed)) flag_item {
-    struct flag _optional;
-    struct flag_item *_next;
-};
-
-static struct flag_item *flag_item_new(char const flag, char const *const l_flag, char const *const placeholder,
-                                       char const *const desc, unsigned int flags, int (*takes)(),
-                                       int (*parse)(struct flag *, char const *const *, int)) {
-    struct flag_item *ctx = malloc(sizeof(struct flag_item));
-    if (ctx != NULL) {
-        flag_init(&ctx->_optional, flag, l_flag, placeholder, desc, flags, takes, parse);
-        ctx->_next = NULL;
+/*!
+ * Takes the next doc of the current block, thus the docs are stored contiguously instead of between the nodes
+ */
+static struct doc *doc_new(struct spec *spec, char const *const placeholder, char const *const desc, size_t width) {
+    if (spec->_docs_free == 0) {
+        struct doc *block = arena_alloc(&spec->_arena, DOC_BLOCK * sizeof(struct doc));
+        if (block == NULL) {
+            return NULL;
+        }
+        spec->_docs = block;
+        spec->_docs_free = DOC_BLOCK;
     }
+    struct doc *ctx = spec->_docs++;
+    spec->_docs_free -= 1;
+    ctx->_placeholder = placeholder;
+    ctx->_desc = desc;
+    ctx->_width = width + (placeholder != NULL ? strlen(placeholder) : 0);
     return ctx;
 }
 
 static struct flag *command_add_flag_item(struct command *ctx, char const flag, char const *const l_flag,
                                           char const *const placeholder, char const *const desc, unsigned int flags,
-                                          int (*takes)(), int (*parse)(struct flag *, char const *const *, int)) {
+                                          unsigned int kind) {
     if (ctx == NULL) {
         return NULL;
     }
 
-    struct flag_item *item = flag_item_new(flag, l_flag, placeholder, desc, flags, takes, parse);
-    if (item != NULL) {
-        if (ctx->_optionals == NULL) {
-            ctx->_optionals = item;
-        } else {
-            struct flag_item *it = ctx->_optionals;
-
-            if (it->_optional._short == flag) {
-                fprintf(stderr, "Option '-%c' is configured for multiple flags.\n", flag);
-                abort();
-            }
-            if (strcmp(it->_optional._long, l_flag) == 0) {
-                fprintf(stderr, "Option '--%s' is configured for multiple flags.\n", l_flag);
-                abort();
-            }
-
-            while (it->_next != NULL) {
-                it = it->_next;
-
-                if (it->_optional._short == flag) {
-                    fprintf(stderr, "Option '-%c' is configured for multiple flags.\n", flag);
-                    abort();
-                }
-                if (strcmp(it->_optional._long, l_flag) == 0) {
-                    fprintf(stderr, "Option '--%s' is configured for multiple flags.\n", l_flag);
-                    abort();
-                }
-            }
-            it->_next = item;
+    STATS_BEGIN(start);
+    for (struct flag const *it = ctx->_optionals; it != NULL; it = it->_next) {
+        STATS_ADD(&ctx->_spec->_stats, comparisons, 1);
+        if (it->_short == flag) {
+            fprintf(stderr, "Option '-%c' is configured for multiple flags.\n", flag);
+            abort();
         }
-        return &item->_optional;
-    } else {
+        if (strcmp(it->_long, l_flag) == 0) {
+            fprintf(stderr, "Option '--%s' is configured for multiple flags.\n", l_flag);
+            abort();
+        }
+    }
+
+    struct arena *arena = &ctx->_spec->_arena;
+    struct doc *doc = doc_new(ctx->_spec, placeholder, desc, strlen(l_flag));
+    struct flag *item = doc != NULL ? arena_alloc(arena, sizeof(struct flag)) : NULL;
+    if (item == NULL) {
         return NULL;
     }
+    flag_init(item, ctx->_spec->_flags++, flag, l_flag, doc, flags, kind);
+    if (ctx->_optionals_last == NULL) {
+        ctx->_optionals = item;
+    } else {
+        ctx->_optionals_last->_next = item;
+    }
+    ctx->_optionals_last = item;
+
+    // Entries and help are rebuilt on next use, the outdated entries are released with the arena
+    ctx->_index = NULL;
+    ctx->_help->_columns = 0;
+    ctx->_spec->_changed = 1;
+
+    STATS_ADD(&ctx->_spec->_stats, nodes, 1);
+    STATS_END(&ctx->_spec->_stats, build_ns, start);
+    return item;
 }
 
 /*********************************************************************************************************************
- * arg_item
+ * command args
  *********************************************************************************************************************/
 
-struct __attribute__((packed)) arg_item {
-    struct arg _required;
-    struct arg_item *_next;
-};
-
-static struct arg_item *arg_item_new(char const *const name, char const *const desc, int (*takes)(),
-                                     int (*parse)(struct arg *, char const *const *, int)) {
-    struct arg_item *ctx = malloc(sizeof(struct arg_item));
-    if (ctx != NULL) {
-        arg_init(&ctx->_required, name, desc, takes, parse);
-        ctx->_next = NULL;
-    }
-    return ctx;
-}
-
 static struct arg *command_add_arg_item(struct command *ctx, char const *const name, char const *const desc,
-                                        int (*takes)(), int (*parse)(struct arg *, char const *const *, int)) {
+                                        unsigned int kind) {
     if (ctx == NULL) {
         return NULL;
     }
 
-    struct arg_item *item = arg_item_new(name, desc, takes, parse);
-    if (item != NULL) {
-        if (ctx->_requires == NULL) {
-            ctx->_requires = item;
-        } else {
-            struct arg_item *it = ctx->_requires;
-
-            if (strcmp(it->_required._name, name) == 0) {
-                fprintf(stderr, "Required argument '%s' is configured multiple times.\n", name);
-                abort();
-            }
-
-            while (it->_next != NULL) {
-                it = it->_next;
-
-                if (strcmp(it->_required._name, name) == 0) {
-                    fprintf(stderr, "Required argument '%s' is configured multiple times.\n", name);
-                    abort();
-                }
-            }
-            it->_next = item;
+    STATS_BEGIN(start);
+    for (struct arg const *it = ctx->_requires; it != NULL; it = it->_next) {
+        STATS_ADD(&ctx->_spec->_stats, comparisons, 1);
+        if (strcmp(it->_name, name) == 0) {
+            fprintf(stderr, "Required argument '%s' is configured multiple times.\n", name);
+            abort();
         }
-        return &item->_required;
-    } else {
-        return NULL;
     }
-}
-
-/*********************************************************************************************************************
- * command_item
- *********************************************************************************************************************/
-
-struct __attribute__((packed)) command_item {
-    struct command _command;
-    struct command_item *_next;
-};
-
-static void command_deinit(struct command *ctx) {
-    ctx->_name = NULL;
-    ctx->_desc = NULL;
-    ctx->_parent = NULL;
-
-    struct command_item *c = ctx->_commands;
-    while (c != NULL) {
-        ctx->_commands = c->_next;
-        command_deinit(&c->_command);
-        free(c);
-        c = ctx->_commands;
+    if (ctx->_requires_last != NULL && ctx->_requires_last->_kind == ARG_KIND_STREAM) {
+        fprintf(stderr, "Required argument '%s' follows the stream argument '%s'.\n", name,
+                ctx->_requires_last->_name);
+        abort();
     }
 
-    struct flag_item *o = ctx->_optionals;
-    while (o != NULL) {
-        ctx->_optionals = o->_next;
-        free(o);
-        o = ctx->_optionals;
+    struct arena *arena = &ctx->_spec->_arena;
+    struct doc *doc = doc_new(ctx->_spec, NULL, desc, strlen(name));
+    struct arg *item = doc != NULL ? arena_alloc(arena, sizeof(struct arg)) : NULL;
+    if (item == NULL) {
+        return NULL;
     }
-
-    struct arg_item *r = ctx->_requires;
-    while (r != NULL) {
-        ctx->_requires = r->_next;
-        free(r);
-        r = ctx->_requires;
+    arg_init(item, ctx->_spec->_args++, name, doc, kind);
+    if (ctx->_requires_last == NULL) {
+        ctx->_requires = item;
+    } else {
+        ctx->_requires_last->_next = item;
     }
+    ctx->_requires_last = item;
+    ctx->_index = NULL;
+    ctx->_help->_columns = 0;
+    ctx->_spec->_changed = 1;
+
+    STATS_ADD(&ctx->_spec->_stats, nodes, 1);
+    STATS_END(&ctx->_spec->_stats, build_ns, start);
+    return item;
 }
 
-static struct command_item *command_item_new(char const *const name, char const *const desc, char const *const footer,
-                                             struct command *parent) {
-    struct command_item *ctx = malloc(sizeof(struct command_item));
-    if (ctx != NULL) {
-        command_init(&ctx->_command, name, desc, footer, parent);
-        ctx->_next = NULL;
-    }
-    return ctx;
-}
+/*********************************************************************************************************************
+ * command subcommands
+ *********************************************************************************************************************/
 
 static struct command *command_add_command_item(struct command *ctx, char const *const name, char const *const desc,
                                                 char const *const footer) {
@@ -443,32 +873,35 @@ static struct command *command_add_command_item(struct command *ctx, char const
         return NULL;
     }
 
-    struct command_item *item = command_item_new(name, desc, footer, ctx);
-    if (item != NULL) {
-        if (ctx->_commands == NULL) {
-            ctx->_commands = item;
-        } else {
-            struct command_item *it = ctx->_commands;
+    STATS_BEGIN(start);
+    for (struct command const *it = ctx->_commands; it != NULL; it = it->_next) {
+        STATS_ADD(&ctx->_spec->_stats, comparisons, 1);
+        if (strcmp(it->_name, name) == 0) {
+            fprintf(stderr, "(Sub-)Command '%s' is configured multiple times.\n", name);
+            abort();
+        }
+    }
 
-            if (strcmp(it->_command._name, name) == 0) {
-                fprintf(stderr, "(Sub-)Command '%s' is configured multiple times.\n", name);
-                abort();
-            }
-
-            while (it->_next != NULL) {
-                it = it->_next;
-
-                if (strcmp(it->_command._name, name) == 0) {
-                    fprintf(stderr, "(Sub-)Command '%s' is configured multiple times.\n", name);
-                    abort();
-                }
-            }
-            it->_next = item;
-        }
-        return &item->_command;
-    } else {
+    struct arena *arena = &ctx->_spec->_arena;
+    struct help *help = arena_alloc(arena, sizeof(struct help));
+    struct command *item = help != NULL ? arena_alloc(arena, sizeof(struct command)) : NULL;
+    if (item == NULL) {
         return NULL;
     }
+    command_init(item, ctx->_spec, name, desc, footer, ctx, help);
+    if (ctx->_commands_last == NULL) {
+        ctx->_commands = item;
+    } else {
+        ctx->_commands_last->_next = item;
+    }
+    ctx->_commands_last = item;
+    ctx->_index = NULL;
+    ctx->_help->_columns = 0;
+    ctx->_spec->_changed = 1;
+
+    STATS_ADD(&ctx->_spec->_stats, nodes, 1);
+    STATS_END(&ctx->_spec->_stats, build_ns, start);
+    return item;
 }
 
 /*********************************************************************************************************************
@@ -482,296 +915,826 @@ struct command *command_add_subcommand(struct command *ctx, char const *const na
 
 struct flag *command_add_flag(struct command *ctx, char const flag, char const *const l_flag, char const *const desc,
                               unsigned int flags) {
-    return command_add_flag_item(ctx, flag, l_flag, NULL, desc, flags, flag_takes, flag_parse);
+    return command_add_flag_item(ctx, flag, l_flag, NULL, desc, flags, FLAG_KIND_FLAG);
 }
 
 struct flag *command_add_flag_value(struct command *ctx, char const flag, char const *const l_flag,
                                     char const *const placeholder, char const *const desc, unsigned int flags) {
-    return command_add_flag_item(ctx, flag, l_flag, placeholder, desc, flags, flag_value_takes, flag_value_parse);
+    return command_add_flag_item(ctx, flag, l_flag, placeholder, desc, flags, FLAG_KIND_VALUE);
 }
 
 struct flag *command_add_flag_list(struct command *ctx, char const flag, char const *const l_flag,
                                    char const *const placeholder, char const *const desc, unsigned int flags) {
-    return command_add_flag_item(ctx, flag, l_flag, placeholder, desc, flags, flag_list_takes, flag_list_parse);
+    return command_add_flag_item(ctx, flag, l_flag, placeholder, desc, flags, FLAG_KIND_LIST);
 }
 
 struct arg *command_add_arg_value(struct command *ctx, char const *const name, char const *const desc) {
-    return command_add_arg_item(ctx, name, desc, arg_value_takes, arg_value_parse);
+    return command_add_arg_item(ctx, name, desc, ARG_KIND_VALUE);
 }
 
 struct arg *command_add_arg_list(struct command *ctx, char const *const name, char const *const desc) {
-    return command_add_arg_item(ctx, name, desc, arg_list_takes, arg_list_parse);
+    return command_add_arg_item(ctx, name, desc, ARG_KIND_LIST);
+}
+
+struct arg *command_add_arg_stream(struct command *ctx, char const *const name, char const *const desc) {
+    return command_add_arg_item(ctx, name, desc, ARG_KIND_STREAM);
 }
 
 /*********************************************************************************************************************
- * Print help message
+ * text
  *********************************************************************************************************************/
 
-static void command_show_help(struct command *ctx) {
-    fprintf(stdout, "\n    Usage: ");
+#define TEXT_MIN_CAPACITY 4096
+#define TEXT_DEFAULT_COLUMNS 80
+#define TEXT_MIN_COLUMNS 20
+
+/*!
+ * Output buffer of help messages. The text is collected and written at once. If the buffer can't grow, its content is
+ * written to the stream in between. Without stream, text exceeding the buffer is only counted.
+ */
+struct text {
+    char *_data;
+    size_t _cap;
+    size_t _len;
+    size_t _total;
+    size_t _columns; /*!< Line width of wrapped text */
+    struct arena *_arena;
+    FILE *_stream;
+};
+
+static void text_init(struct text *ctx, char *data, size_t cap, struct arena *arena, FILE *stream) {
+    ctx->_data = data;
+    ctx->_cap = cap;
+    ctx->_len = 0;
+    ctx->_total = 0;
+    ctx->_columns = TEXT_DEFAULT_COLUMNS;
+    ctx->_arena = arena;
+    ctx->_stream = stream;
+}
 
-    // Print parent arguments to provide full commandline
-    struct command *processed = NULL;
-    while (processed != ctx->_parent) {
-        struct command *c = ctx->_parent;
-        while (c->_parent != processed) {
-            c = c->_parent;
+/*!
+ * Width of the terminal connected to stdout, otherwise given by the COLUMNS environment variable or 80
+ */
+static size_t terminal_columns(void) {
+#if defined(ARGPARSE_POSIX) && defined(TIOCGWINSZ)
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0) {
+        return ws.ws_col;
+    }
+#endif
+    char const *columns = getenv("COLUMNS");
+    if (columns != NULL) {
+        long cnt = strtol(columns, NULL, 10);
+        if (cnt > 0) {
+            return (size_t)cnt;
         }
-        fprintf(stdout, "%s ", c->_name);
-        processed = c;
     }
+    return TEXT_DEFAULT_COLUMNS;
+}
 
-    fprintf(stdout, "%s ", ctx->_name);
+/*!
+ * Doubles the capacity until n more bytes fit, outgrown buffers are released with the arena
+ */
+static int text_grow(struct text *ctx, size_t n) {
+    if (ctx->_arena == NULL) {
+        return -1;
+    }
+    size_t cap = ctx->_cap > 0 ? ctx->_cap : TEXT_MIN_CAPACITY;
+    while (cap < ctx->_len + n) {
+        cap *= 2;
+    }
+    char *data = arena_alloc(ctx->_arena, cap);
+    if (data == NULL) {
+        return -1;
+    }
+    if (ctx->_len > 0) {
+        memcpy(data, ctx->_data, ctx->_len);
+    }
+    ctx->_data = data;
+    ctx->_cap = cap;
+    return 0;
+}
 
-    if (ctx->_optionals != NULL) {
-        fprintf(stdout, "[OPTIONS] ");
+/*!
+ * Writes the data at once, pending output of the stream is flushed before
+ */
+static void stream_write(FILE *stream, char const *data, size_t len) {
+    fflush(stream);
+#ifdef ARGPARSE_POSIX
+    // Terminals are line buffered, a single write(..) avoids one system call per line
+    int fd = fileno(stream);
+    while (len > 0) {
+        ssize_t cnt = write(fd, data, len);
+        if (cnt < 0 && errno == EINTR) {
+            continue;
+        }
+        if (cnt <= 0) {
+            // Nothing was written, retrying would spin forever
+            break;
+        }
+        data += cnt;
+        len -= cnt;
     }
-    if (ctx->_commands != NULL) {
-        fprintf(stdout, "[COMMAND] ");
+#else
+    fwrite(data, 1, len, stream);
+    fflush(stream);
+#endif
+}
+
+static void text_flush(struct text *ctx) {
+    if (ctx->_stream != NULL && ctx->_len > 0) {
+        stream_write(ctx->_stream, ctx->_data, ctx->_len);
+        ctx->_len = 0;
     }
+}
 
-    struct arg_item *r = ctx->_requires;
-    while (r != NULL) {
-        fprintf(stdout, "%s ", r->_required._name);
-        if (r->_required.takes() > 1) {
-            fprintf(stdout, "[%s...] ", r->_required._name);
+static void text_put(struct text *ctx, char const *str, size_t n) {
+    ctx->_total += n;
+    if (ctx->_cap - ctx->_len < n && text_grow(ctx, n) != 0) {
+        text_flush(ctx);
+        if (ctx->_stream != NULL && ctx->_cap < n) {
+            fwrite(str, 1, n, ctx->_stream);
+            return;
         }
-        r = r->_next;
     }
-    fprintf(stdout, "\n\n");
+    size_t cnt = ctx->_cap - ctx->_len < n ? ctx->_cap - ctx->_len : n;
+    if (cnt > 0) {
+        memcpy(ctx->_data + ctx->_len, str, cnt);
+        ctx->_len += cnt;
+    }
+}
 
-    // Format description, supports manual linebreaks but also adds linebreaks to keep format
-    if (ctx->_desc != NULL) {
-        char const *start = ctx->_desc;
-        char const *end = ctx->_desc;
+static void text_str(struct text *ctx, char const *str) { text_put(ctx, str, strlen(str)); }
 
-        while (*start != '\0') {
-            char const *pos = end;
-            while (*pos != '\0' && *pos != ' ' && *pos != '\n') {
-                ++pos;
-            }
-            if (*pos == '\0') {
-                fprintf(stdout, "    %s\n", start);
-                break;
-            } else {
-                if (*pos == '\n' || (pos - start) > 80) {
-                    fprintf(stdout, "    %.*s\n", (int)(pos - start), start);
-                    start = pos + 1;
-                    end = pos + 1;
-                } else {
-                    end = pos + 1;
-                }
-            }
+static void text_pad(struct text *ctx, size_t n) {
+    static char const spaces[] = "                                ";
+    while (n > 0) {
+        size_t cnt = n < sizeof(spaces) - 1 ? n : sizeof(spaces) - 1;
+        text_put(ctx, spaces, cnt);
+        n -= cnt;
+    }
+}
+
+/*!
+ * Appends the words of str wrapped to the line width, the current line is at column `indent` and all following lines
+ * are indented by it. Manual linebreaks are kept, words exceeding a whole line are never split. Each character is
+ * visited once, thus the layout is linear in the length of the text.
+ */
+static void text_wrap(struct text *ctx, char const *str, size_t indent) {
+    size_t avail = ctx->_columns > indent + TEXT_MIN_COLUMNS ? ctx->_columns - indent : TEXT_MIN_COLUMNS;
+    size_t used = 0;
+    int pad = 0;
+
+    while (*str != '\0') {
+        if (*str == ' ') {
+            ++str;
+            continue;
+        }
+        if (*str == '\n') {
+            text_put(ctx, "\n", 1);
+            used = 0;
+            pad = 1;
+            ++str;
+            continue;
+        }
+
+        char const *end = str;
+        while (*end != '\0' && *end != ' ' && *end != '\n') {
+            ++end;
+        }
+        size_t len = end - str;
+        if (used > 0 && used + 1 + len > avail) {
+            text_put(ctx, "\n", 1);
+            used = 0;
+            pad = 1;
+        }
+        if (pad) {
+            // Indent only lines with content, empty lines stay free of trailing spaces
+            text_pad(ctx, indent);
+            pad = 0;
+        }
+        if (used > 0) {
+            text_put(ctx, " ", 1);
+            used += 1;
         }
-        fprintf(stdout, "\n");
+        text_put(ctx, str, len);
+        used += len;
+        str = end;
     }
+}
 
-    // Display all supported options
-    if (ctx->_optionals != NULL) {
-        int width = 4;
-        struct flag_item *opt = ctx->_optionals;
-        while (opt != NULL) {
-            int len = strlen(opt->_optional._long);
-            if (opt->_optional._placeholder != NULL) {
-                len += strlen(opt->_optional._placeholder);
-            }
-            if (len + 7 > width) {
-                width = len + 7;
+/*********************************************************************************************************************
+ * Print help message
+ *********************************************************************************************************************/
+
+/*!
+ * Format description, supports manual linebreaks but also adds linebreaks to keep format
+ */
+static void text_paragraph(struct text *out, char const *text) {
+    text_put(out, "    ", 4);
+    text_wrap(out, text, 4);
+    text_put(out, "\n\n", 2);
+}
+
+static void text_flag(struct text *out, struct flag const *opt, size_t width) {
+    char const short_flag[] = {' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', '-', opt->_short, ',', ' ', '-', '-'};
+    text_put(out, short_flag, sizeof(short_flag));
+    text_put(out, opt->_long, opt->_len);
+    if (opt->_doc->_placeholder == NULL) {
+        text_pad(out, width - opt->_len);
+        text_wrap(out, opt->_doc->_desc, sizeof(short_flag) + width);
+        text_put(out, "\n", 1);
+    } else {
+        text_put(out, " <", 2);
+        text_str(out, opt->_doc->_placeholder);
+        text_put(out, ">", 1);
+        text_pad(out, width - opt->_doc->_width - 3);
+        text_wrap(out, opt->_doc->_desc, sizeof(short_flag) + width);
+        text_put(out, " \n", 2);
+    }
+}
+
+static void text_flags(struct text *out, struct command const *ctx, char const *title, unsigned int required,
+                       size_t width) {
+    int printed = 0;
+    for (struct flag const *opt = ctx->_optionals; opt != NULL; opt = opt->_next) {
+        if ((opt->_flags & SET_REQUIRED) == required) {
+            if (printed == 0) {
+                text_str(out, title);
+                printed = 1;
             }
-            opt = opt->_next;
+            text_flag(out, opt, width);
         }
+    }
+    if (printed == 1) {
+        text_put(out, "\n", 1);
+    }
+}
 
-        int printed = 0;
-        opt = ctx->_optionals;
-        while (opt != NULL) {
-            if ((opt->_optional._flags & SET_REQUIRED) == SET_REQUIRED) {
-                if (printed == 0) {
-                    fprintf(stdout, "    Required flags:\n\n");
-                    printed = 1;
-                }
-                if (opt->_optional._placeholder == NULL) {
-                    fprintf(stdout, "        -%c, --%-*s%s\n", opt->_optional._short, width, opt->_optional._long,
-                            opt->_optional._desc);
-                } else {
-                    fprintf(stdout, "        -%c, --%s <%s>%-*s%s \n", opt->_optional._short, opt->_optional._long,
-                            opt->_optional._placeholder,
-                            (int)(width - strlen(opt->_optional._long) - strlen(opt->_optional._placeholder)) - 3, "",
-                            opt->_optional._desc);
-                }
-            }
-            opt = opt->_next;
+/*!
+ * Print names of the command and its parents to provide full commandline
+ */
+static void text_path(struct text *out, struct command const *ctx) {
+    if (ctx->_parent != NULL) {
+        text_path(out, ctx->_parent);
+    }
+    text_put(out, ctx->_name, ctx->_len);
+    text_put(out, " ", 1);
+}
+
+/*!
+ * Line width of help messages, either given by parser_set_columns(..) or of the terminal
+ */
+static size_t command_columns(struct command const *ctx) {
+    return ctx->_spec->_columns > 0 ? ctx->_spec->_columns : terminal_columns();
+}
+
+static void command_render_help_into(struct command const *ctx, struct text *out, size_t columns) {
+    out->_columns = columns;
+    text_str(out, "\n    Usage: ");
+    text_path(out, ctx);
+
+    if (ctx->_optionals != NULL) {
+        text_str(out, "[OPTIONS] ");
+    }
+    if (ctx->_commands != NULL) {
+        text_str(out, "[COMMAND] ");
+    }
+
+    for (struct arg const *r = ctx->_requires; r != NULL; r = r->_next) {
+        if (r->_kind == ARG_KIND_STREAM) {
+            // Values of a stream are optional on the commandline
+            text_put(out, "[", 1);
+            text_put(out, r->_name, r->_doc->_width);
+            text_put(out, "...] ", 5);
+            continue;
         }
-        if (printed == 1) {
-            fprintf(stdout, "\n");
+        text_put(out, r->_name, r->_doc->_width);
+        text_put(out, " ", 1);
+        if (arg_kind_takes(r->_kind) > 1) {
+            text_put(out, "[", 1);
+            text_put(out, r->_name, r->_doc->_width);
+            text_put(out, "...] ", 5);
         }
+    }
+    text_put(out, "\n\n", 2);
 
-        printed = 0;
-        opt = ctx->_optionals;
-        while (opt != NULL) {
-            if ((opt->_optional._flags & SET_REQUIRED) != SET_REQUIRED) {
-                if (printed == 0) {
-                    fprintf(stdout, "    Optional flags:\n\n");
-                    printed = 1;
-                }
-                if (opt->_optional._placeholder == NULL) {
-                    fprintf(stdout, "        -%c, --%-*s%s\n", opt->_optional._short, width, opt->_optional._long,
-                            opt->_optional._desc);
-                } else {
-                    fprintf(stdout, "        -%c, --%s <%s>%-*s%s \n", opt->_optional._short, opt->_optional._long,
-                            opt->_optional._placeholder,
-                            (int)(width - strlen(opt->_optional._long) - strlen(opt->_optional._placeholder)) - 3, "",
-                            opt->_optional._desc);
-                }
+    if (ctx->_desc != NULL) {
+        text_paragraph(out, ctx->_desc);
+    }
+
+    // Display all supported options
+    if (ctx->_optionals != NULL) {
+        size_t width = 4;
+        for (struct flag const *opt = ctx->_optionals; opt != NULL; opt = opt->_next) {
+            size_t len = opt->_doc->_width;
+            if (len + 7 > width) {
+                width = len + 7;
             }
-            opt = opt->_next;
-        }
-        if (printed == 1) {
-            fprintf(stdout, "\n");
         }
+        text_flags(out, ctx, "    Required flags:\n\n", SET_REQUIRED, width);
+        text_flags(out, ctx, "    Optional flags:\n\n", SET_NONE, width);
     }
 
     // Display all supported commands
     if (ctx->_commands != NULL) {
-        int width = 4;
-        struct command_item *cmd = ctx->_commands;
-        while (cmd != NULL) {
-            int len = strlen(cmd->_command._name);
+        size_t width = 4;
+        for (struct command const *cmd = ctx->_commands; cmd != NULL; cmd = cmd->_next) {
+            size_t len = cmd->_len;
             if (len + 4 > width) {
                 width = len + 4;
             }
-            cmd = cmd->_next;
         }
 
-        cmd = ctx->_commands;
-        fprintf(stdout, "    Commands:\n\n");
-        while (cmd != NULL) {
-            fprintf(stdout, "        %-*s%s\n", width, cmd->_command._name, cmd->_command._desc);
-            cmd = cmd->_next;
+        text_str(out, "    Commands:\n\n");
+        for (struct command const *cmd = ctx->_commands; cmd != NULL; cmd = cmd->_next) {
+            text_pad(out, 8);
+            text_put(out, cmd->_name, cmd->_len);
+            text_pad(out, width - cmd->_len);
+            text_wrap(out, cmd->_desc, 8 + width);
+            text_put(out, "\n", 1);
         }
-        fprintf(stdout, "\n");
+        text_put(out, "\n", 1);
     }
 
     // Display all required arguments
     if (ctx->_requires != NULL) {
-        int width = 4;
-        struct arg_item *req = ctx->_requires;
-        while (req != NULL) {
-            int len = strlen(req->_required._name);
+        size_t width = 4;
+        for (struct arg const *req = ctx->_requires; req != NULL; req = req->_next) {
+            size_t len = req->_doc->_width;
             if (len + 4 > width) {
                 width = len + 4;
             }
-            req = req->_next;
         }
 
-        req = ctx->_requires;
-        fprintf(stdout, "    Required arguments:\n\n");
-        while (req != NULL) {
-            fprintf(stdout, "        %-*s%s\n", width, req->_required._name, req->_required._desc);
-            req = req->_next;
+        text_str(out, "    Required arguments:\n\n");
+        for (struct arg const *req = ctx->_requires; req != NULL; req = req->_next) {
+            text_pad(out, 8);
+            text_put(out, req->_name, req->_doc->_width);
+            text_pad(out, width - req->_doc->_width);
+            text_wrap(out, req->_doc->_desc, 8 + width);
+            text_put(out, "\n", 1);
         }
-        fprintf(stdout, "\n");
+        text_put(out, "\n", 1);
     }
 
-    // Format footer
     if (ctx->_footer != NULL) {
-        char const *start = ctx->_footer;
-        char const *end = ctx->_footer;
+        text_paragraph(out, ctx->_footer);
+    }
+}
 
-        while (*start != '\0') {
-            char const *pos = end;
-            while (*pos != '\0' && *pos != ' ' && *pos != '\n') {
-                ++pos;
-            }
-            if (*pos == '\0') {
-                fprintf(stdout, "    %s\n", start);
-                break;
-            } else {
-                if (*pos == '\n' || (pos - start) > 80) {
-                    fprintf(stdout, "    %.*s\n", (int)(pos - start), start);
-                    start = pos + 1;
-                    end = pos + 1;
-                } else {
-                    end = pos + 1;
-                }
-            }
+size_t command_render_help(struct command const *ctx, char *buffer, size_t size) {
+    if (ctx == NULL) {
+        return 0;
+    }
+    size_t columns = command_columns(ctx);
+    struct text out;
+    text_init(&out, buffer, size > 0 ? size - 1 : 0, NULL, NULL);
+    if (ctx->_help->_columns == columns) {
+        text_put(&out, ctx->_help->_data, ctx->_help->_len);
+    } else {
+        command_render_help_into(ctx, &out, columns);
+    }
+    if (size > 0) {
+        buffer[out._len] = '\0';
+    }
+    return out._total;
+}
+
+/*!
+ * Renders the help message for the line width into the arena of the parser, the command keeps it until modified or
+ * another width is requested. The previous buffer is reused if the message fits.
+ */
+static int command_cache_help(struct command const *ctx, size_t columns) {
+    struct help *help = ctx->_help;
+    if (help->_columns == columns) {
+        return 0;
+    }
+    struct text out;
+    text_init(&out, NULL, 0, NULL, NULL);
+    command_render_help_into(ctx, &out, columns);
+
+    size_t len = out._total;
+    if (len + 1 > help->_cap) {
+        char *data = arena_alloc(&ctx->_spec->_arena, len + 1);
+        if (data == NULL) {
+            return -1;
         }
-        fprintf(stdout, "\n");
+        help->_data = data;
+        help->_cap = len + 1;
     }
+    text_init(&out, help->_data, len, NULL, NULL);
+    command_render_help_into(ctx, &out, columns);
+    help->_data[len] = '\0';
+    help->_len = len;
+    help->_columns = columns;
+    return 0;
 }
 
 /*********************************************************************************************************************
  * Parsing utility
  *********************************************************************************************************************/
 
+/*!
+ * Kind of a single commandline argument, determined once per parse
+ */
+enum token_kind { TOKEN_WORD = 0, TOKEN_FLAG, TOKEN_SEPARATOR, TOKEN_HELP };
+
+struct token {
+    int _kind;
+    int _len;
+    int _words;
+};
+
+/*!
+ * Classifies all arguments in a single pass. Additionally stores for each position the number of consecutive
+ * plain words starting there, thus the end of a value list is known without rescanning argv. The count is
+ * relative, so subcommands can operate on the tail of the token array.
+ */
+static void tokenize(struct token *tokens, char const *const *argv, int argc) {
+    int words = 0;
+    for (int i = argc - 1; i >= 0; --i) {
+        char const *const arg = argv[i];
+        int len = strlen(arg);
+        int kind = TOKEN_WORD;
+
+        if (len > 1 && arg[0] == '-') {
+            if (len == 2 && arg[1] == '-') {
+                kind = TOKEN_SEPARATOR;
+            } else if ((len == 2 && arg[1] == 'h') || (len == 6 && strcmp(arg, "--help") == 0)) {
+                kind = TOKEN_HELP;
+            } else {
+                kind = TOKEN_FLAG;
+            }
+        }
+        words = kind == TOKEN_WORD ? words + 1 : 0;
+
+        tokens[i]._kind = kind;
+        tokens[i]._len = len;
+        tokens[i]._words = words;
+    }
+}
+
+/*!
+ * Result of parse runs, reused by all runs. Keeps all slots that were modified, thus a reset only visits those. The
+ * result embedded in the parser stores the values in the nodes through tables bound by parser_finalize(..), any other
+ * result stores them in its own slots and leaves the nodes untouched.
+ */
+struct parse_result {
+    struct slot *_flags;
+    struct slot *_args;
+    unsigned char *_commands;
+    size_t _flag_cnt;
+    size_t _arg_cnt;
+    size_t _command_cnt;
+
+    // Slots and markers of the nodes indexed by id, only used by the result embedded in the parser
+    struct slot **_node_flags;
+    struct slot **_node_args;
+    unsigned char **_node_commands;
+
+    // Buffer of help messages, kept for the next help message
+    char *_help;
+    size_t _help_cap;
+
+    // Slots and markers modified by the current run. Each one is recorded once, thus sized by the number of nodes.
+    struct slot **_touched_flags;
+    struct slot **_touched_args;
+    unsigned char **_touched_commands;
+    size_t _touched_flag_cnt;
+    size_t _touched_arg_cnt;
+    size_t _touched_command_cnt;
+    struct arena *_arena;
+    struct parser_stats *_stats;
+};
+
+static void parse_result_init_in(struct parse_result *ctx, struct arena *arena, struct parser_stats *stats) {
+    ctx->_flags = NULL;
+    ctx->_args = NULL;
+    ctx->_commands = NULL;
+    ctx->_flag_cnt = 0;
+    ctx->_arg_cnt = 0;
+    ctx->_command_cnt = 0;
+    ctx->_node_flags = NULL;
+    ctx->_node_args = NULL;
+    ctx->_node_commands = NULL;
+    ctx->_help = NULL;
+    ctx->_help_cap = 0;
+    ctx->_touched_flags = NULL;
+    ctx->_touched_args = NULL;
+    ctx->_touched_commands = NULL;
+    ctx->_touched_flag_cnt = 0;
+    ctx->_touched_arg_cnt = 0;
+    ctx->_touched_command_cnt = 0;
+    ctx->_arena = arena;
+    ctx->_stats = stats;
+}
+
+static struct slot *parse_result_flag_slot(struct parse_result const *ctx, size_t id) {
+    return ctx->_flags == NULL ? ctx->_node_flags[id] : &ctx->_flags[id];
+}
+
+static struct slot *parse_result_arg_slot(struct parse_result const *ctx, size_t id) {
+    return ctx->_args == NULL ? ctx->_node_args[id] : &ctx->_args[id];
+}
+
+static unsigned char *parse_result_command_set(struct parse_result const *ctx, size_t id) {
+    return ctx->_commands == NULL ? ctx->_node_commands[id] : &ctx->_commands[id];
+}
+
+/*!
+ * Returns a token buffer for argc arguments, the buffer only grows if a run exceeds all previous ones. It's the
+ * scratch buffer of the arena, thus no heap is used with caller-owned buffers and growth never leaks the old one.
+ */
+static struct token *parse_result_tokens(struct parse_result *ctx, int argc) {
+    size_t cnt = argc > 0 ? argc : 1;
+    return arena_scratch(ctx->_arena, sizeof(struct token) * cnt);
+}
+
+static void parse_result_clear(struct parse_result *ctx) {
+    for (size_t i = 0; i < ctx->_touched_flag_cnt; ++i) {
+        slot_clear(ctx->_touched_flags[i]);
+    }
+    for (size_t i = 0; i < ctx->_touched_arg_cnt; ++i) {
+        slot_clear(ctx->_touched_args[i]);
+    }
+    for (size_t i = 0; i < ctx->_touched_command_cnt; ++i) {
+        *ctx->_touched_commands[i] = 0;
+    }
+    ctx->_touched_flag_cnt = 0;
+    ctx->_touched_arg_cnt = 0;
+    ctx->_touched_command_cnt = 0;
+}
+
+/*!
+ * Parses the flag on first use and records it as modified, later uses call flag_kind_parse(..) directly
+ */
+static int parse_result_flag_first(struct parse_result *ctx, struct flag_entry const *opt, struct slot *slot,
+                                   char const *const *argv, int argc) {
+    int used = flag_kind_parse(opt->_kind, slot, argv, argc);
+    if (used >= 0) {
+        ctx->_touched_flags[ctx->_touched_flag_cnt++] = slot;
+    }
+    return used;
+}
+
+/*!
+ * Parses the arg and records it as modified
+ */
+static int parse_result_arg(struct parse_result *ctx, struct arg_entry const *arg, char const *const *argv,
+                            int argc) {
+    STATS_BEGIN(start);
+    struct slot *slot = parse_result_arg_slot(ctx, arg->_id);
+    int used = arg_kind_parse(arg->_kind, slot, argv, argc);
+    STATS_END(ctx->_stats, store_ns, start);
+    if (used >= 0) {
+        ctx->_touched_args[ctx->_touched_arg_cnt++] = slot;
+    }
+    return used;
+}
+
+/*!
+ * Marks the command as processed, fails if it was already processed
+ */
+static int parse_result_command(struct parse_result *ctx, struct command const *cmd) {
+    unsigned char *set = parse_result_command_set(ctx, cmd->_id);
+    if (*set != 0) {
+        return -1;
+    }
+    *set = 1;
+    ctx->_touched_commands[ctx->_touched_command_cnt++] = set;
+    return 0;
+}
+
+/*!
+ * Find the subcommand matching the given argument
+ */
+static struct command const *command_find_subcommand(struct command const *ctx, struct parser_stats *stats,
+                                                     char const *const arg, int len) {
+    for (size_t i = 0; i < ctx->_subcommand_cnt; ++i) {
+        struct command_entry const *c = &ctx->_subcommands[i];
+        if (c->_len == (size_t)len) {
+            STATS_ADD(stats, comparisons, 1);
+            if (strcmp(arg, c->_name) == 0) {
+                return c->_command;
+            }
+        }
+    }
+    return NULL;
+}
+
 /*!
  * Find the next argument position that is option or command
  */
-static int idx_of_next_opt(struct command *ctx, char const *const *argv, int argc, int start) {
-    for (int i = start; i < argc; ++i) {
-        if (*argv[i] == '-') {
-            return i;
-        } else {
-            int arg_len = strlen(argv[i]);
-            struct command_item *c = ctx->_commands;
-            while (c != NULL) {
-                int c_len = strlen(c->_command._name);
-                if (c_len == arg_len && strcmp(argv[i], c->_command._name) == 0) {
-                    return i;
-                }
-                c = c->_next;
+static int idx_of_next_opt(struct command const *ctx, struct parser_stats *stats, char const *const *argv,
+                           struct token const *tokens, int argc, int start) {
+    if (start >= argc) {
+        return argc;
+    }
+
+    int limit = start + tokens[start]._words;
+    if (ctx->_subcommand_cnt > 0) {
+        STATS_BEGIN(begin);
+        for (int i = start; i < limit; ++i) {
+            if (command_find_subcommand(ctx, stats, argv[i], tokens[i]._len) != NULL) {
+                limit = i;
+                break;
             }
         }
+        STATS_END(stats, lookup_ns, begin);
     }
-    return argc;
+    return limit;
+}
+
+/*!
+ * FNV-1a hash of the given string
+ */
+static size_t hash_str(char const *const str, size_t len) {
+    size_t hash = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= (unsigned char)str[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/*!
+ * Builds the direct-indexed table of short flags, the open-addressing table of long flags and the contiguous entries
+ * of all flags, args and subcommands in a single allocation sized exactly. It's kept until the command is modified.
+ */
+static int command_finalize(struct command *ctx) {
+    if (ctx->_index != NULL) {
+        return 0;
+    }
+
+    size_t flags = 0;
+    size_t args = 0;
+    size_t commands = 0;
+    for (struct flag const *o = ctx->_optionals; o != NULL; o = o->_next) {
+        ++flags;
+    }
+    for (struct arg const *r = ctx->_requires; r != NULL; r = r->_next) {
+        ++args;
+    }
+    for (struct command const *c = ctx->_commands; c != NULL; c = c->_next) {
+        ++commands;
+    }
+
+    // Keep load factor below 0.5 to ensure short probe sequences
+    size_t size = 4;
+    while (size < 2 * flags) {
+        size <<= 1;
+    }
+
+    // All parts are multiples of the pointer size, thus each one is aligned
+    size_t index_size = (256 + size) * sizeof(struct flag_entry const *);
+    char *mem = arena_alloc(&ctx->_spec->_arena, index_size + flags * sizeof(struct flag_entry) +
+                                                     args * sizeof(struct arg_entry) +
+                                                     commands * sizeof(struct command_entry));
+    if (mem == NULL) {
+        return -1;
+    }
+    struct flag_entry const **index = (struct flag_entry const **)mem;
+    struct flag_entry *flag_entries = (struct flag_entry *)(mem + index_size);
+    struct arg_entry *arg_entries = (struct arg_entry *)(flag_entries + flags);
+    struct command_entry *command_entries = (struct command_entry *)(arg_entries + args);
+    memset(index, 0, index_size);
+
+    struct flag_entry const **longs = &index[256];
+    struct flag_entry *e = flag_entries;
+    for (struct flag const *o = ctx->_optionals; o != NULL; o = o->_next, ++e) {
+        e->_short = o->_short;
+        e->_kind = o->_kind;
+        e->_flags = o->_flags;
+        e->_id = o->_id;
+        e->_len = o->_len;
+        e->_long = o->_long;
+        e->_node = o;
+        index[(unsigned char)e->_short] = e;
+
+        size_t i = hash_str(e->_long, e->_len) & (size - 1);
+        while (longs[i] != NULL) {
+            i = (i + 1) & (size - 1);
+        }
+        longs[i] = e;
+    }
+    struct arg_entry *a = arg_entries;
+    for (struct arg const *r = ctx->_requires; r != NULL; r = r->_next, ++a) {
+        a->_kind = r->_kind;
+        a->_id = r->_id;
+    }
+    struct command_entry *s = command_entries;
+    for (struct command const *c = ctx->_commands; c != NULL; c = c->_next, ++s) {
+        s->_len = c->_len;
+        s->_name = c->_name;
+        s->_command = c;
+    }
+
+    ctx->_index = index;
+    ctx->_mask = size - 1;
+    ctx->_flags = flag_entries;
+    ctx->_args = arg_entries;
+    ctx->_subcommands = command_entries;
+    ctx->_flag_cnt = flags;
+    ctx->_arg_cnt = args;
+    ctx->_subcommand_cnt = commands;
+    return 0;
+}
+
+/*!
+ * Find the flag with the given long name
+ */
+static struct flag_entry const *command_find_flag(struct command const *ctx, struct parser_stats *stats,
+                                                  char const *const name, size_t len) {
+    struct flag_entry const *const *longs = &ctx->_index[256];
+    size_t i = hash_str(name, len) & ctx->_mask;
+    while (longs[i] != NULL) {
+        struct flag_entry const *opt = longs[i];
+        if (opt->_len == len) {
+            STATS_ADD(stats, comparisons, 1);
+            if (memcmp(opt->_long, name, len) == 0) {
+                return opt;
+            }
+        }
+        i = (i + 1) & ctx->_mask;
+    }
+    return NULL;
+}
+
+/*!
+ * Prints the help message of the command
+ */
+static void command_help(struct command const *ctx, struct parse_result *result) {
+    STATS_BEGIN(start);
+    size_t columns = command_columns(ctx);
+    if (result->_flags == NULL) {
+        // Only parser_parse_args(..) may refill the cache, results rely on the messages cached by parser_finalize(..)
+        command_cache_help(ctx, columns);
+    }
+    if (ctx->_help->_columns == columns) {
+        stream_write(stdout, ctx->_help->_data, ctx->_help->_len);
+    } else {
+        struct text out;
+        text_init(&out, result->_help, result->_help_cap, result->_arena, stdout);
+        command_render_help_into(ctx, &out, columns);
+        text_flush(&out);
+        result->_help = out._data;
+        result->_help_cap = out._cap;
+    }
+    STATS_END(result->_stats, help_ns, start);
 }
 
 /*!
  * Parses option, supports flag duplicates using `-v -v -v` or `-vvv`
  */
-static int parse_flag(struct command *ctx, char const *const *argv, int argc, char const *const arg) {
+static int parse_flag(struct command const *ctx, struct parse_result *result, char const *const *argv, int argc,
+                      char const *const arg, int len) {
     int used = -1;
     int is_short = arg[1] == '-' ? 0 : 1;
 
     if (is_short == 1) {
         // Parse e.g. `-v` and `-vvvv`
-        int len = strlen(arg);
+        // Bundles are the hottest path, thus the kind of result is only checked once
+        struct slot *slots = result->_flags;
+        struct slot *const *nodes = result->_node_flags;
         for (int i = 1; i < len; ++i) {
-            struct flag_item *opt = ctx->_optionals;
-            while (opt != NULL) {
-                if (opt->_optional._short == arg[i]) {
-                    break;
-                };
-                opt = opt->_next;
-            }
-
+            STATS_BEGIN(lookup);
+            struct flag_entry const *opt = ctx->_index[(unsigned char)arg[i]];
+            STATS_END(result->_stats, lookup_ns, lookup);
             if (opt == NULL) {
                 return -1;
             }
 
-            used = (used == -1 ? 0 : used) + opt->_optional.parse(&opt->_optional, argv, argc);
+            STATS_BEGIN(store);
+            struct slot *slot = slots == NULL ? nodes[opt->_id] : &slots[opt->_id];
+            int res = slot->_count != 0 ? flag_kind_parse(opt->_kind, slot, argv, argc)
+                                        : parse_result_flag_first(result, opt, slot, argv, argc);
+            STATS_END(result->_stats, store_ns, store);
+            if (res == -1) {
+                used = -1;
+                break;
+            }
+            used = (used == -1 ? 0 : used) + res;
         }
     } else {
         // Parse e.g. `--verbose`
-        int len = strlen(&arg[2]);
-        struct flag_item *opt = ctx->_optionals;
-        while (opt != NULL) {
-            int opt_len = strlen(opt->_optional._long);
-            if (len == opt_len && strcmp(opt->_optional._long, &arg[2]) == 0) {
-                break;
-            };
-            opt = opt->_next;
-        }
-
+        STATS_BEGIN(lookup);
+        struct flag_entry const *opt = command_find_flag(ctx, result->_stats, &arg[2], len - 2);
+        STATS_END(result->_stats, lookup_ns, lookup);
         if (opt == NULL) {
             return -1;
         }
 
-        used = opt->_optional.parse(&opt->_optional, argv, argc);
+        STATS_BEGIN(store);
+        struct slot *slot = parse_result_flag_slot(result, opt->_id);
+        used = slot->_count != 0 ? flag_kind_parse(opt->_kind, slot, argv, argc)
+                                 : parse_result_flag_first(result, opt, slot, argv, argc);
+        STATS_END(result->_stats, store_ns, store);
     }
 
     // Show help if parsing failed
     if (used == -1) {
-        command_show_help(ctx);
+        command_help(ctx, result);
         return -1;
     }
 
@@ -782,101 +1745,107 @@ static int parse_flag(struct command *ctx, char const *const *argv, int argc, ch
  * Parsing argument for command
  *********************************************************************************************************************/
 
-static int command_check_if_required(struct flag_item *o) {
-    while (o != NULL) {
-        if ((o->_optional._flags & SET_REQUIRED) == SET_REQUIRED) {
-            int takes = o->_optional.takes();
-            int _count = o->_optional._count;
-            if (takes > _count) {
-                if (o->_optional.takes() > 1) {
-                    fprintf(stderr, "Missing option: -%c, --%s <%s...>\n", o->_optional._short, o->_optional._long,
-                            o->_optional._placeholder);
+static int command_check_if_required(struct command const *ctx, struct parse_result const *result) {
+    for (size_t i = 0; i < ctx->_flag_cnt; ++i) {
+        struct flag_entry const *o = &ctx->_flags[i];
+        if ((o->_flags & SET_REQUIRED) == SET_REQUIRED) {
+            int takes = flag_kind_takes(o->_kind);
+            if ((size_t)takes > parse_result_flag_slot(result, o->_id)->_count) {
+                char const *placeholder = o->_node->_doc->_placeholder;
+                if (takes > 1) {
+                    fprintf(stderr, "Missing option: -%c, --%s <%s...>\n", o->_short, o->_long, placeholder);
                 } else {
-                    fprintf(stderr, "Missing option: -%c, --%s <%s> \n", o->_optional._short, o->_optional._long,
-                            o->_optional._placeholder);
+                    fprintf(stderr, "Missing option: -%c, --%s <%s> \n", o->_short, o->_long, placeholder);
                 }
                 return -1;
             }
         }
-        o = o->_next;
     }
     return 0;
 }
 
-static int command_parse_args(struct command *ctx, char const *const *argv, int argc) {
-    // Forbid multiple processing of same command
-    if (ctx->_set != 0) {
+/*!
+ * Whether the command has arguments that must be given on the commandline. A stream is always the last argument.
+ */
+static int command_requires_values(struct command const *ctx) {
+    return ctx->_arg_cnt > 1 || (ctx->_arg_cnt == 1 && ctx->_args[0]._kind != ARG_KIND_STREAM);
+}
+
+static int command_parse_args(struct command const *ctx, struct parse_result *result, char const *const *argv,
+                              struct token const *tokens, int argc) {
+    // The lookup tables are built by parser_finalize(..) before any parse run
+    assert(ctx->_index != NULL);
+
+    // Forbid multiple processing of same command, requires parser_reset(..) in between
+    if (parse_result_command(result, ctx) != 0) {
         return -1;
     }
-    struct arg_item *r = NULL;
-    ctx->_set = 1;
     int pos = 1;
+    int end = 1;
     while (pos < argc) {
-        int len = strlen(argv[pos]);
-        int end = idx_of_next_opt(ctx, argv, argc, pos + 1);
+        // Values of a flag never span an option or command, thus the boundary is only recomputed once passed
+        if (end <= pos) {
+            end = idx_of_next_opt(ctx, result->_stats, argv, tokens, argc, pos + 1);
+        }
 
-        if ((len == 6 && strcmp(argv[pos], "--help") == 0) || (len == 2 && strcmp(argv[pos], "-h") == 0)) {
+        if (tokens[pos]._kind == TOKEN_HELP) {
             // Show help if requested
-            command_show_help(ctx);
+            command_help(ctx, result);
             return -1;
-        } else if (len > 1 && *argv[pos] == '-' && (len != 2 || argv[pos][1] != '-')) {
-            // Support `--` to force continuation with required arguments
-            int used = parse_flag(ctx, &argv[pos + 1], end - pos - 1, argv[pos]);
+        } else if (tokens[pos]._kind == TOKEN_FLAG) {
+            int used = parse_flag(ctx, result, &argv[pos + 1], end - pos - 1, argv[pos], tokens[pos]._len);
             if (used < 0) {
                 return -1;
             }
             pos += used;
-        } else if (pos < argc) {
+        } else {
             // Check if argument is command and if so, parse command
-            struct command_item *c = NULL;
-            if (argv[pos][0] != '-') {
-                c = ctx->_commands;
-                while (c != NULL) {
-                    int c_len = strlen(c->_command._name);
-                    if (len == c_len && strcmp(argv[pos], c->_command._name) == 0) {
-                        int used = command_parse_args(&c->_command, &argv[pos], argc - pos);
-                        if (used == -1) {
-                            return -1;
-                        }
-                        pos += used;
-                        break;
+            struct command const *c = NULL;
+            if (tokens[pos]._kind == TOKEN_WORD) {
+                STATS_BEGIN(lookup);
+                c = command_find_subcommand(ctx, result->_stats, argv[pos], tokens[pos]._len);
+                STATS_END(result->_stats, lookup_ns, lookup);
+                if (c != NULL) {
+                    int used = command_parse_args(c, result, &argv[pos], &tokens[pos], argc - pos);
+                    if (used == -1) {
+                        return -1;
                     }
-                    c = c->_next;
+                    pos += used;
                 }
-            } else if (len == 2 && argv[pos][1] == '-') {
-                // Skip '--'
+            } else {
+                // Support `--` to force continuation with required arguments
                 pos += 1;
             }
             // Check for required arguments if arguments remaining and no subcommand was parsed
             if (pos < argc && c == NULL) {
-                r = ctx->_requires;
-                while (r != NULL) {
+                for (size_t i = 0; i < ctx->_arg_cnt; ++i) {
                     if (pos >= argc) {
-                        return -1;
+                        // Only the values of a stream may be omitted, they are read afterwards
+                        if (ctx->_args[i]._kind != ARG_KIND_STREAM) {
+                            return -1;
+                        }
+                        break;
                     }
-                    int used = r->_required.parse(&r->_required, &argv[pos], argc - pos);
+                    int used = parse_result_arg(result, &ctx->_args[i], &argv[pos], argc - pos);
                     if (used == -1) {
                         return -1;
                     }
                     pos += used;
-                    r = r->_next;
                 }
 
-                if (command_check_if_required(ctx->_optionals) != 0) {
+                if (command_check_if_required(ctx, result) != 0) {
                     return -1;
                 } else {
                     return pos;
                 }
             }
-        } else {
-            return -1;
         }
     }
 
-    if (command_check_if_required(ctx->_optionals) != 0) {
+    if (command_check_if_required(ctx, result) != 0) {
         return -1;
     } else {
-        return ctx->_requires == NULL ? pos : -1;
+        return command_requires_values(ctx) ? -1 : pos;
     }
 }
 
@@ -886,22 +1855,72 @@ static int command_parse_args(struct command *ctx, char const *const *argv, int
 
 struct parser {
     struct command _internal;
+    struct parse_result _result;
+    struct spec _spec;
 };
 
-struct parser *parser_init(char const *const name, char const *const desc, char const *const footer) {
-    struct parser *ctx = malloc(sizeof(struct parser));
-    if (ctx != NULL) {
-        command_init(&ctx->_internal, name, desc, footer, NULL);
+/*!
+ * Creates the parser as first allocation of the given arena, the arena is owned by the parser afterwards
+ */
+static struct parser *parser_create(struct arena *arena, char const *const name, char const *const desc,
+                                    char const *const footer) {
+    struct parser *ctx = arena_alloc(arena, sizeof(struct parser));
+    struct help *help = ctx != NULL ? arena_alloc(arena, sizeof(struct help)) : NULL;
+    if (help == NULL) {
+        arena_free(arena);
+        return NULL;
     }
+    spec_init(&ctx->_spec, arena);
+    command_init(&ctx->_internal, &ctx->_spec, name, desc, footer, NULL, help);
+    parse_result_init_in(&ctx->_result, &ctx->_spec._arena, &ctx->_spec._stats);
     return ctx;
 }
 
+struct parser *parser_init(char const *const name, char const *const desc, char const *const footer) {
+    return parser_init_sized(name, desc, footer, ARENA_BLOCK_SIZE);
+}
+
+struct parser *parser_init_sized(char const *const name, char const *const desc, char const *const footer,
+                                 size_t size) {
+    struct arena arena;
+    arena_init(&arena, NULL, size);
+    return parser_create(&arena, name, desc, footer);
+}
+
+struct parser *parser_init_static(char const *const name, char const *const desc, char const *const footer,
+                                  void *buffer, size_t size) {
+    struct arena arena;
+    if (buffer == NULL || arena_init(&arena, buffer, size) != 0) {
+        return NULL;
+    }
+    return parser_create(&arena, name, desc, footer);
+}
+
 void parser_deinit(struct parser *ctx) {
     if (ctx == NULL) {
         return;
     }
-    command_deinit(&ctx->_internal);
-    free(ctx);
+    // Parser itself is located inside of the arena
+    struct arena arena = ctx->_spec._arena;
+    arena_free(&arena);
+}
+
+size_t parser_render_help(struct parser const *ctx, char *buffer, size_t size) {
+    return ctx == NULL ? 0 : command_render_help(&ctx->_internal, buffer, size);
+}
+
+static void command_drop_help_all(struct command *ctx) {
+    ctx->_help->_columns = 0;
+    for (struct command *c = ctx->_commands; c != NULL; c = c->_next) {
+        command_drop_help_all(c);
+    }
+}
+
+void parser_set_columns(struct parser *ctx, size_t columns) {
+    if (ctx != NULL) {
+        ctx->_spec._columns = columns;
+        command_drop_help_all(&ctx->_internal);
+    }
 }
 
 struct command *parser_add_command(struct parser *ctx, char const *const name, char const *const desc,
@@ -910,31 +1929,597 @@ struct command *parser_add_command(struct parser *ctx, char const *const name, c
 }
 
 struct flag *parser_add_flag(struct parser *ctx, char const flag, char const *const l_flag, char const *const desc) {
-    return command_add_flag_item(&ctx->_internal, flag, l_flag, NULL, desc, SET_NONE, flag_takes, flag_parse);
+    return command_add_flag_item(&ctx->_internal, flag, l_flag, NULL, desc, SET_NONE, FLAG_KIND_FLAG);
 }
 
 struct flag *parser_add_flag_value(struct parser *ctx, char const flag, char const *const l_flag,
                                    const char *const placeholder, char const *const desc, unsigned int flags) {
-    return command_add_flag_item(&ctx->_internal, flag, l_flag, placeholder, desc, flags, flag_value_takes,
-                                 flag_value_parse);
+    return command_add_flag_item(&ctx->_internal, flag, l_flag, placeholder, desc, flags, FLAG_KIND_VALUE);
 }
 
 struct flag *parser_add_flag_list(struct parser *ctx, char const flag, char const *const l_flag,
                                   const char *const placeholder, char const *const desc, unsigned int flags) {
-    return command_add_flag_item(&ctx->_internal, flag, l_flag, placeholder, desc, flags, flag_list_takes,
-                                 flag_list_parse);
+    return command_add_flag_item(&ctx->_internal, flag, l_flag, placeholder, desc, flags, FLAG_KIND_LIST);
 }
 
 struct arg *parser_add_arg_value(struct parser *ctx, char const *const name, char const *const desc) {
-    return command_add_arg_item(&ctx->_internal, name, desc, arg_value_takes, arg_value_parse);
+    return command_add_arg_item(&ctx->_internal, name, desc, ARG_KIND_VALUE);
 }
 
 struct arg *parser_add_arg_list(struct parser *ctx, char const *const name, char const *const desc) {
-    return command_add_arg_item(&ctx->_internal, name, desc, arg_list_takes, arg_list_parse);
+    return command_add_arg_item(&ctx->_internal, name, desc, ARG_KIND_LIST);
+}
+
+struct arg *parser_add_arg_stream(struct parser *ctx, char const *const name, char const *const desc) {
+    return command_add_arg_item(&ctx->_internal, name, desc, ARG_KIND_STREAM);
+}
+
+/*!
+ * Classifies the arguments and parses them starting at the root command
+ */
+static int parse_args(struct command const *root, struct parse_result *result, char const *const *argv, int argc) {
+    STATS_BEGIN(start);
+    struct token *tokens = parse_result_tokens(result, argc);
+    if (tokens == NULL) {
+        return 1;
+    }
+    tokenize(tokens, argv, argc);
+    STATS_END(result->_stats, classify_ns, start);
+    STATS_ADD(result->_stats, tokens, argc);
+
+    int res = command_parse_args(root, result, argv, tokens, argc) == argc ? 0 : 1;
+    STATS_END(result->_stats, parse_ns, start);
+    return res;
+}
+
+/*!
+ * Builds the lookup tables of the command and all its subcommands and binds the slots of the nodes to the result
+ */
+static int command_finalize_all(struct command *ctx, struct parse_result *result) {
+    if (command_finalize(ctx) != 0) {
+        return -1;
+    }
+    result->_node_commands[ctx->_id] = &ctx->_set;
+    for (struct flag *o = ctx->_optionals; o != NULL; o = o->_next) {
+        result->_node_flags[o->_id] = &o->_slot;
+    }
+    for (struct arg *r = ctx->_requires; r != NULL; r = r->_next) {
+        result->_node_args[r->_id] = &r->_slot;
+    }
+    for (struct command *c = ctx->_commands; c != NULL; c = c->_next) {
+        if (command_finalize_all(c, result) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*!
+ * Renders the help messages of the command and all its subcommands, without space they're rendered on each request
+ */
+static void command_cache_help_all(struct command const *ctx, size_t columns) {
+    command_cache_help(ctx, columns);
+    for (struct command const *c = ctx->_commands; c != NULL; c = c->_next) {
+        command_cache_help_all(c, columns);
+    }
+}
+
+/*!
+ * Prepares the tree for parse runs if nodes were added since the last call. Afterwards the parse path only reads the
+ * nodes, the values of parser_parse_args(..) are written through the tables of the embedded result. The help messages
+ * are cached here as well, results sharing the parser never modify the cache.
+ */
+static int parser_finalize(struct parser *ctx) {
+    struct spec *spec = &ctx->_spec;
+    if (!spec->_changed) {
+        return 0;
+    }
+
+    // Sized exactly, the outdated tables of a parser modified after parsing are released with the arena
+    struct parse_result *result = &ctx->_result;
+    size_t nodes = spec->_flags + spec->_args;
+    struct slot **slots = arena_alloc(&spec->_arena, 2 * nodes * sizeof(struct slot *));
+    unsigned char **sets = slots != NULL ? arena_alloc(&spec->_arena, 2 * spec->_commands * sizeof(unsigned char *))
+                                         : NULL;
+    if (sets == NULL) {
+        return -1;
+    }
+
+    // Values of a run not yet reset stay recorded
+    struct slot **touched = slots + nodes;
+    if (result->_touched_flags != NULL) {
+        memcpy(touched, result->_touched_flags, result->_touched_flag_cnt * sizeof(struct slot *));
+        memcpy(touched + spec->_flags, result->_touched_args, result->_touched_arg_cnt * sizeof(struct slot *));
+        memcpy(sets + spec->_commands, result->_touched_commands,
+               result->_touched_command_cnt * sizeof(unsigned char *));
+    }
+    result->_touched_flags = touched;
+    result->_touched_args = touched + spec->_flags;
+    result->_touched_commands = sets + spec->_commands;
+
+    result->_node_flags = slots;
+    result->_node_args = slots + spec->_flags;
+    result->_node_commands = sets;
+    if (command_finalize_all(&ctx->_internal, result) != 0) {
+        return -1;
+    }
+    command_cache_help_all(&ctx->_internal, command_columns(&ctx->_internal));
+    spec->_changed = 0;
+    return 0;
 }
 
 int parser_parse_args(struct parser *ctx, char const *const *argv, int argc) {
-    return command_parse_args(&ctx->_internal, argv, argc) == argc ? 0 : 1;
+    if (parser_finalize(ctx) != 0) {
+        return 1;
+    }
+    return parse_args(&ctx->_internal, &ctx->_result, argv, argc);
+}
+
+void parser_reset(struct parser *ctx) {
+    if (ctx != NULL) {
+        parse_result_clear(&ctx->_result);
+    }
+}
+
+int parser_parse_args_into(struct parser const *ctx, struct parse_result *result, char const *const *argv,
+                           int argc) {
+    if (ctx == NULL || result == NULL) {
+        return 1;
+    }
+    // Nodes added after creation of the result have neither slots nor lookup tables
+    if (result->_flag_cnt != ctx->_spec._flags || result->_arg_cnt != ctx->_spec._args ||
+        result->_command_cnt != ctx->_spec._commands) {
+        return 1;
+    }
+
+    parse_result_clear(result);
+
+    // Only the result is modified, the nodes are read-only
+    return parse_args(&ctx->_internal, result, argv, argc);
+}
+
+/*********************************************************************************************************************
+ * Parse result
+ *********************************************************************************************************************/
+
+struct parse_result *parse_result_init(struct parser *parser) {
+    if (parser == NULL || parser_finalize(parser) != 0) {
+        return NULL;
+    }
+
+    struct arena arena;
+    arena_init(&arena, NULL, ARENA_BLOCK_SIZE);
+
+    struct spec const *spec = &parser->_spec;
+    size_t nodes = spec->_flags + spec->_args;
+    size_t size = align_up(sizeof(struct parse_result)) + align_up(sizeof(struct arena)) +
+                  align_up(sizeof(struct parser_stats)) + nodes * sizeof(struct slot) +
+                  (nodes + spec->_commands) * sizeof(void *) + spec->_commands;
+    char *mem = arena_alloc(&arena, size);
+    if (mem == NULL) {
+        arena_free(&arena);
+        return NULL;
+    }
+    memset(mem, 0, size);
+
+    // The result owns the arena and its statistics, both are located directly behind the result
+    struct parse_result *ctx = (struct parse_result *)mem;
+    struct arena *own = (struct arena *)(mem + align_up(sizeof(struct parse_result)));
+    struct parser_stats *stats = (struct parser_stats *)((char *)own + align_up(sizeof(struct arena)));
+    *own = arena;
+    parse_result_init_in(ctx, own, stats);
+
+    struct slot *slots = (struct slot *)((char *)stats + align_up(sizeof(struct parser_stats)));
+    struct slot **touched = (struct slot **)(slots + nodes);
+    unsigned char **sets = (unsigned char **)(touched + nodes);
+    ctx->_flags = slots;
+    ctx->_args = slots + spec->_flags;
+    ctx->_commands = (unsigned char *)(sets + spec->_commands);
+    ctx->_touched_flags = touched;
+    ctx->_touched_args = touched + spec->_flags;
+    ctx->_touched_commands = sets;
+    ctx->_flag_cnt = spec->_flags;
+    ctx->_arg_cnt = spec->_args;
+    ctx->_command_cnt = spec->_commands;
+    return ctx;
+}
+
+void parse_result_deinit(struct parse_result *ctx) {
+    if (ctx == NULL) {
+        return;
+    }
+    // Result itself is located inside of the arena
+    struct arena arena = *ctx->_arena;
+    arena_free(&arena);
+}
+
+static struct slot const *parse_result_get_flag(struct parse_result const *ctx, struct flag const *flag) {
+    if (ctx == NULL || flag == NULL || ctx->_flags == NULL || flag->_id >= ctx->_flag_cnt) {
+        return NULL;
+    }
+    return &ctx->_flags[flag->_id];
+}
+
+static struct slot const *parse_result_get_arg(struct parse_result const *ctx, struct arg const *arg) {
+    if (ctx == NULL || arg == NULL || ctx->_args == NULL || arg->_id >= ctx->_arg_cnt) {
+        return NULL;
+    }
+    return &ctx->_args[arg->_id];
+}
+
+size_t parse_result_flag_count(struct parse_result const *ctx, struct flag const *flag) {
+    struct slot const *slot = parse_result_get_flag(ctx, flag);
+    return slot != NULL ? slot->_count : 0;
+}
+
+char const *parse_result_flag_value_get(struct parse_result const *ctx, struct flag const *value) {
+    struct slot const *slot = parse_result_get_flag(ctx, value);
+    return slot != NULL && slot->_values != NULL ? *slot->_values : NULL;
+}
+
+char const *const *parse_result_flag_list_get(struct parse_result const *ctx, struct flag const *list) {
+    struct slot const *slot = parse_result_get_flag(ctx, list);
+    return slot != NULL ? slot->_values : NULL;
+}
+
+char const *parse_result_arg_value_get(struct parse_result const *ctx, struct arg const *value) {
+    struct slot const *slot = parse_result_get_arg(ctx, value);
+    return slot != NULL && slot->_values != NULL ? *slot->_values : NULL;
+}
+
+size_t parse_result_arg_list_count(struct parse_result const *ctx, struct arg const *list) {
+    struct slot const *slot = parse_result_get_arg(ctx, list);
+    return slot != NULL ? slot->_count : 0;
+}
+
+char const *const *parse_result_arg_list_get(struct parse_result const *ctx, struct arg const *list) {
+    struct slot const *slot = parse_result_get_arg(ctx, list);
+    return slot != NULL ? slot->_values : NULL;
+}
+
+int parse_result_arg_stream_read(struct parse_result const *ctx, struct arg const *stream, int fd, char delim,
+                                 arg_stream_fn fn, void *data) {
+    struct slot const *slot = parse_result_get_arg(ctx, stream);
+    if (slot == NULL || stream->_kind != ARG_KIND_STREAM || fn == NULL) {
+        return -1;
+    }
+    return arg_stream_deliver(stream, slot, fd, delim, fn, data);
+}
+
+int parse_result_command_is_set(struct parse_result const *ctx, struct command const *cmd) {
+    if (ctx == NULL || cmd == NULL || ctx->_commands == NULL || cmd->_id >= ctx->_command_cnt) {
+        return 0;
+    }
+    return ctx->_commands[cmd->_id];
+}
+
+/*********************************************************************************************************************
+ * Response files
+ *********************************************************************************************************************/
+
+#define RESPONSE_MAX_DEPTH 16
+#define RESPONSE_READ_SIZE 65536
+
+#ifdef MAP_POPULATE
+#define RESPONSE_MAP_FLAGS MAP_POPULATE
+#else
+#define RESPONSE_MAP_FLAGS 0
+#endif
+
+/*!
+ * Content of a single response file, either mapped or read into the heap
+ */
+struct response_file {
+    struct response_file *_next;
+    char *_data;
+    size_t _len; /*!< Length of the region including the terminating byte */
+    int _mapped;
+};
+
+struct response_args {
+    char const **_argv;
+    int _argc;
+    size_t _cap;
+    size_t _size;  /*!< Bytes of all response files */
+    size_t _limit; /*!< Maximum of _size, 0 if unlimited */
+    struct response_file *_files;
+};
+
+static int response_args_push(struct response_args *ctx, char const *arg) {
+    if ((size_t)ctx->_argc == ctx->_cap) {
+        size_t cap = ctx->_cap == 0 ? 64 : ctx->_cap * 2;
+        if (cap > (size_t)INT32_MAX) {
+            return -1;
+        }
+        char const **argv = realloc(ctx->_argv, cap * sizeof(char const *));
+        if (argv == NULL) {
+            return -1;
+        }
+        ctx->_argv = argv;
+        ctx->_cap = cap;
+    }
+    ctx->_argv[ctx->_argc++] = arg;
+    return 0;
+}
+
+static int response_args_reserve(struct response_args *ctx, char const *path, size_t size) {
+    if (ctx->_limit > 0 && (size > ctx->_limit || ctx->_size > ctx->_limit - size)) {
+        fprintf(stderr, "Response file '%s' exceeds the size limit.\n", path);
+        return -1;
+    }
+    ctx->_size += size;
+    return 0;
+}
+
+/*!
+ * Reads the whole stream into the heap, used for pipes and if mapping is not supported
+ */
+static struct response_file *response_file_read(struct response_args *ctx, char const *path, FILE *stream) {
+    struct response_file *file = calloc(1, sizeof(struct response_file));
+    size_t cap = 0;
+    size_t len = 0;
+    while (file != NULL) {
+        if (cap - len < RESPONSE_READ_SIZE + 1) {
+            cap = cap == 0 ? RESPONSE_READ_SIZE + 1 : cap * 2;
+            char *data = realloc(file->_data, cap);
+            if (data == NULL) {
+                break;
+            }
+            file->_data = data;
+        }
+        size_t cnt = fread(file->_data + len, 1, RESPONSE_READ_SIZE, stream);
+        if (cnt > 0 && response_args_reserve(ctx, path, cnt) != 0) {
+            break;
+        }
+        len += cnt;
+        if (cnt < RESPONSE_READ_SIZE) {
+            if (ferror(stream)) {
+                fprintf(stderr, "Unable to read response file '%s'.\n", path);
+                break;
+            }
+            file->_data[len] = '\0';
+            file->_len = len + 1;
+            return file;
+        }
+    }
+    if (file != NULL) {
+        free(file->_data);
+        free(file);
+    }
+    return NULL;
+}
+
+/*!
+ * Loads the response file into a private writable region followed by one zero byte, thus tokens are terminated in
+ * place. Regular files are mapped and only paged in while tokenized.
+ */
+static struct response_file *response_file_open(struct response_args *ctx, char const *path) {
+#ifdef ARGPARSE_POSIX
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        fprintf(stderr, "Unable to open response file '%s'.\n", path);
+        return NULL;
+    }
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        size_t size = (size_t)st.st_size;
+        struct response_file *file = NULL;
+        if (response_args_reserve(ctx, path, size) == 0 && (file = calloc(1, sizeof(struct response_file))) != NULL) {
+            // Reserve one byte more than the file, the mapping of the file ends at a page boundary. Tokenizing
+            // writes to nearly every page, thus all pages are faulted in at once if supported.
+            char *data = mmap(NULL, size + 1, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (data != MAP_FAILED &&
+                mmap(data, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED | RESPONSE_MAP_FLAGS, fd, 0) ==
+                    MAP_FAILED) {
+                munmap(data, size + 1);
+                data = MAP_FAILED;
+            }
+            if (data != MAP_FAILED) {
+                file->_data = data;
+                file->_len = size + 1;
+                file->_mapped = 1;
+            } else {
+                fprintf(stderr, "Unable to map response file '%s'.\n", path);
+                free(file);
+                file = NULL;
+            }
+        }
+        close(fd);
+        return file;
+    }
+    FILE *stream = fdopen(fd, "rb");
+    if (stream == NULL) {
+        close(fd);
+        fprintf(stderr, "Unable to open response file '%s'.\n", path);
+        return NULL;
+    }
+#else
+    FILE *stream = fopen(path, "rb");
+    if (stream == NULL) {
+        fprintf(stderr, "Unable to open response file '%s'.\n", path);
+        return NULL;
+    }
+#endif
+    struct response_file *file = response_file_read(ctx, path, stream);
+    fclose(stream);
+    return file;
+}
+
+static void response_file_close(struct response_file *file) {
+#ifdef ARGPARSE_POSIX
+    if (file->_mapped) {
+        munmap(file->_data, file->_len);
+    } else {
+        free(file->_data);
+    }
+#else
+    free(file->_data);
+#endif
+    free(file);
+}
+
+static int response_args_expand(struct response_args *ctx, char const *path, int depth);
+
+enum response_class { RESPONSE_PLAIN = 0, RESPONSE_SPACE, RESPONSE_SPECIAL };
+
+// Class of each byte, plain bytes are skipped without inspecting quotes
+static unsigned char const response_classes[256] = {
+    [' '] = RESPONSE_SPACE, ['\t'] = RESPONSE_SPACE,  ['\n'] = RESPONSE_SPACE,  ['\r'] = RESPONSE_SPACE,
+    ['\v'] = RESPONSE_SPACE, ['\f'] = RESPONSE_SPACE, ['"'] = RESPONSE_SPECIAL, ['\''] = RESPONSE_SPECIAL,
+    ['\\'] = RESPONSE_SPECIAL,
+};
+
+#define RESPONSE_CLASS(c) response_classes[(unsigned char)(c)]
+
+/*!
+ * Splits the content into whitespace separated tokens. Single quotes take everything literally, inside of double
+ * quotes a backslash only escapes '"' and '\', outside of quotes it escapes any character. Removing quotes and
+ * escapes only shrinks a token, thus each is written back to its own position and terminated by a zero byte.
+ */
+static int response_file_tokenize(struct response_args *ctx, char const *path, char *data, size_t len, int depth) {
+    char *end = data + len;
+    char *pos = data;
+    while (pos < end) {
+        if (RESPONSE_CLASS(*pos) == RESPONSE_SPACE) {
+            ++pos;
+            continue;
+        }
+
+        // Only a leading '@' outside of quotes names a response file, thus "@name", '@name' and \@name are literal
+        // arguments. Quotes following the '@' belong to the name, e.g. @"a b" names the file 'a b'.
+        int nested = *pos == '@';
+        char *token = pos;
+        while (pos < end && RESPONSE_CLASS(*pos) == RESPONSE_PLAIN) {
+            ++pos;
+        }
+
+        // Quotes and escapes are removed by copying the remainder of the token
+        char *out = pos;
+        char quote = '\0';
+        while (pos < end && (quote != '\0' || RESPONSE_CLASS(*pos) != RESPONSE_SPACE)) {
+            char c = *pos++;
+            if (quote == '\'') {
+                if (c == '\'') {
+                    quote = '\0';
+                } else {
+                    *out++ = c;
+                }
+            } else if (c == '\\' && pos < end && (quote == '\0' || *pos == '"' || *pos == '\\')) {
+                *out++ = *pos++;
+            } else if (c == '"' && quote == '"') {
+                quote = '\0';
+            } else if ((c == '"' || c == '\'') && quote == '\0') {
+                quote = c;
+            } else {
+                *out++ = c;
+            }
+        }
+        if (quote != '\0') {
+            fprintf(stderr, "Unterminated quote in response file '%s'.\n", path);
+            return -1;
+        }
+
+        // Both positions are equal if nothing was removed, the separator is consumed before it is overwritten
+        pos += pos < end ? 1 : 0;
+        *out = '\0';
+        int ret = nested && token[1] != '\0' ? response_args_expand(ctx, &token[1], depth + 1)
+                                               : response_args_push(ctx, token);
+        if (ret != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*!
+ * Appends the arguments of the response file
+ */
+static int response_args_expand(struct response_args *ctx, char const *path, int depth) {
+    if (depth > RESPONSE_MAX_DEPTH) {
+        fprintf(stderr, "Response file '%s' is nested too deeply.\n", path);
+        return -1;
+    }
+
+    struct response_file *file = response_file_open(ctx, path);
+    if (file == NULL) {
+        return -1;
+    }
+    file->_next = ctx->_files;
+    ctx->_files = file;
+    return response_file_tokenize(ctx, path, file->_data, file->_len - 1, depth);
+}
+
+/*!
+ * Appends the argument, or the arguments of the response file named by it
+ */
+static int response_args_add(struct response_args *ctx, char const *arg, int depth) {
+    if (arg[0] != '@' || arg[1] == '\0') {
+        return response_args_push(ctx, arg);
+    }
+    return response_args_expand(ctx, &arg[1], depth);
+}
+
+struct response_args *response_args_init(char const *const *argv, int argc, size_t limit) {
+    struct response_args *ctx = calloc(1, sizeof(struct response_args));
+    if (ctx == NULL) {
+        return NULL;
+    }
+    ctx->_limit = limit;
+
+    for (int i = 0; i < argc; ++i) {
+        // Name of the application is never expanded
+        if ((i == 0 ? response_args_push(ctx, argv[i]) : response_args_add(ctx, argv[i], 1)) != 0) {
+            response_args_deinit(ctx);
+            return NULL;
+        }
+    }
+    // Terminated the same way as argv of main
+    if (response_args_push(ctx, NULL) != 0) {
+        response_args_deinit(ctx);
+        return NULL;
+    }
+    ctx->_argc -= 1;
+    return ctx;
+}
+
+void response_args_deinit(struct response_args *ctx) {
+    if (ctx == NULL) {
+        return;
+    }
+    while (ctx->_files != NULL) {
+        struct response_file *next = ctx->_files->_next;
+        response_file_close(ctx->_files);
+        ctx->_files = next;
+    }
+    free(ctx->_argv);
+    free(ctx);
+}
+
+char const *const *response_args_argv(struct response_args const *ctx) { return ctx != NULL ? ctx->_argv : NULL; }
+
+int response_args_argc(struct response_args const *ctx) { return ctx != NULL ? ctx->_argc : 0; }
+
+/*********************************************************************************************************************
+ * Statistics
+ *********************************************************************************************************************/
+
+struct parser_stats const *parser_get_stats(struct parser *ctx) {
+    if (ctx == NULL) {
+        return NULL;
+    }
+    ctx->_spec._stats.bytes = ctx->_spec._arena._bytes;
+    return &ctx->_spec._stats;
+}
+
+struct parser_stats const *parse_result_get_stats(struct parse_result *ctx) {
+    if (ctx == NULL) {
+        return NULL;
+    }
+    ctx->_stats->bytes = ctx->_arena->_bytes;
+    return ctx->_stats;
 }
 
 /*********************************************************************************************************************/
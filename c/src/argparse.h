@@ -25,6 +25,8 @@
 #ifndef __ARGPARSE_C__
 #define __ARGPARSE_C__
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern C {
 #endif
@@ -40,9 +42,9 @@ extern C {
      * @brief Returns how many times the flag was provided
      *
      * @param flag The optional flags structure
-     * @return The number of occurrences of the flag
+     * @return The number of occurrences of the flag, 0 if flag is NULL
      */
-    int flag_count(struct flag * flag);
+    size_t flag_count(struct flag * flag);
 
     /*!
      * @brief Returns whether the flag is set (1) or unset (0)
@@ -79,10 +81,10 @@ extern C {
     /*!
      * @brief Returns the count of provided values
      *
-     * @param list    The optional list structure
-     * @return int    The count of available values
+     * @param list       The optional list structure
+     * @return size_t    The count of available values, 0 if list is NULL
      */
-    int flag_list_count(struct flag * list);
+    size_t flag_list_count(struct flag * list);
 
     /*!
      * @brief Returns the pointer to the array of values
@@ -108,10 +110,10 @@ extern C {
     /*!
      * @brief Returns the count of provided values
      *
-     * @param list    The arg list structure
-     * @return int    The count of available values
+     * @param list       The arg list structure
+     * @return size_t    The count of available values, 0 if list is NULL
      */
-    int arg_list_count(struct arg * list);
+    size_t arg_list_count(struct arg * list);
 
     /*!
      * @brief Returns the pointer to the array of values
@@ -121,6 +123,31 @@ extern C {
      */
     char const *const *arg_list_get(struct arg * list);
 
+    /*!
+     * @brief Callback receiving the values of a stream argument
+     *
+     * @param value   Null terminated value, only valid during the call
+     * @param data    User data given to arg_stream_read(..)
+     * @return int    0 to continue, any other value stops reading and is returned
+     */
+    typedef int (*arg_stream_fn)(char const *value, void *data);
+
+    /*!
+     * @brief Delivers the values of the stream argument one by one
+     *
+     * The values given on the commandline are delivered if any. Otherwise, or if only "-" is given, the values are
+     * read from the file descriptor, each terminated by the delimiter, until its end. Empty values are skipped.
+     * Memory use is bounded, thus a single value may not exceed 64 KiB.
+     *
+     * @param stream  The arg stream structure
+     * @param fd      File descriptor to read from, e.g. 0 for stdin
+     * @param delim   Delimiter of the values, e.g. '\n' or '\0'
+     * @param fn      Callback receiving each value
+     * @param data    User data passed to the callback
+     * @return int    0 after all values, -1 on failure, else the value returned by the callback
+     */
+    int arg_stream_read(struct arg * stream, int fd, char delim, arg_stream_fn fn, void *data);
+
     /*!
      * @brief Command type, utilized for parser and subcommands
      */
@@ -209,6 +236,31 @@ extern C {
      */
     struct arg *command_add_arg_list(struct command * ctx, char const *const name, char const *const desc);
 
+    /*!
+     * @brief Add new arg stream to command, its values are read by arg_stream_read(..)
+     *
+     * Values may be given on the commandline or are read from a file descriptor afterwards, thus the stream has to
+     * be the last arg of the command.
+     *
+     * @param ctx                 The parent command structure
+     * @param name                Name of the stream
+     * @param desc                Description of the stream
+     * @return struct arg*   Reference to the newly added arg stream
+     */
+    struct arg *command_add_arg_stream(struct command * ctx, char const *const name, char const *const desc);
+
+    /*!
+     * @brief Renders the help message of the command into the given buffer
+     *
+     * The message is truncated to size - 1 bytes and always null terminated if size is not 0, same as snprintf(..).
+     *
+     * @param ctx                 The command structure
+     * @param buffer              Buffer receiving the message, may be NULL if size is 0
+     * @param size                Size of the buffer in bytes
+     * @return size_t             Length of the complete message, excluding the null terminator
+     */
+    size_t command_render_help(struct command const *ctx, char *buffer, size_t size);
+
     /*!
      * @brief Parser structure holding all optional/arg values and commands
      */
@@ -224,6 +276,36 @@ extern C {
      */
     struct parser *parser_init(char const *const name, char const *const desc, char const *const footer);
 
+    /*!
+     * @brief Initializes a new parser structure, all nodes are allocated from blocks of the given size
+     *
+     * A size covering the whole parser tree results in a single heap allocation. Call parser_deinit(..) to free it.
+     *
+     * @param name               Name of the application (most likely argv[0])
+     * @param desc               Description of the application, custom linebreaks supported
+     * @param footer             Optional footer text
+     * @param size               Size of each allocated block in bytes
+     * @return struct parser*    Reference to the newly allocated parser structure
+     */
+    struct parser *parser_init_sized(char const *const name, char const *const desc, char const *const footer,
+                                     size_t size);
+
+    /*!
+     * @brief Initializes a new parser structure inside of a caller-owned buffer without any heap allocation
+     *
+     * Adding arguments fails (returns NULL) if the buffer is exhausted. The buffer has to outlive the parser,
+     * parser_deinit(..) may be called but never frees the buffer.
+     *
+     * @param name               Name of the application (most likely argv[0])
+     * @param desc               Description of the application, custom linebreaks supported
+     * @param footer             Optional footer text
+     * @param buffer             Caller-owned memory used for all allocations
+     * @param size               Size of the buffer in bytes
+     * @return struct parser*    Reference to the parser structure located in the buffer, NULL if buffer is too small
+     */
+    struct parser *parser_init_static(char const *const name, char const *const desc, char const *const footer,
+                                      void *buffer, size_t size);
+
     /*!
      * @brief Deinitializes the parser structure, freeing all optional/arg parameters and subcommands
      *
@@ -231,6 +313,27 @@ extern C {
      */
     void parser_deinit(struct parser * ctx);
 
+    /*!
+     * @brief Renders the help message of the parser into the given buffer, see command_render_help(..)
+     *
+     * @param ctx                The parser context
+     * @param buffer             Buffer receiving the message, may be NULL if size is 0
+     * @param size               Size of the buffer in bytes
+     * @return size_t            Length of the complete message, excluding the null terminator
+     */
+    size_t parser_render_help(struct parser const *ctx, char *buffer, size_t size);
+
+    /*!
+     * @brief Sets the line width of help messages, descriptions are wrapped at word boundaries to fit
+     *
+     * By default the width of the terminal connected to stdout is used, otherwise the COLUMNS environment variable
+     * or 80 columns.
+     *
+     * @param ctx                The parser context
+     * @param columns            Line width in characters, 0 to detect it
+     */
+    void parser_set_columns(struct parser * ctx, size_t columns);
+
     /*!
      * @brief Adds a new command to the parser
      *
@@ -303,6 +406,16 @@ extern C {
      */
     struct arg *parser_add_arg_list(struct parser * ctx, char const *const name, char const *const desc);
 
+    /*!
+     * @brief Adds a new arg stream to the parser, see command_add_arg_stream(..)
+     *
+     * @param ctx                  The parser context
+     * @param name                 Name of the arg stream
+     * @param desc                 Description of the arg stream
+     * @return struct arg*    Reference to the created arg stream
+     */
+    struct arg *parser_add_arg_stream(struct parser * ctx, char const *const name, char const *const desc);
+
     /*!
      * @brief Parsing of the given arguments
      *
@@ -313,6 +426,180 @@ extern C {
      */
     int parser_parse_args(struct parser * ctx, char const *const *argv, int argc);
 
+    /*!
+     * @brief Clears the results of the previous parser_parse_args(..) call, so the parser can be used again
+     *
+     * Only the flags, arguments and commands that were set by the previous call are visited. Buffers used for
+     * parsing are kept, thus parsing again doesn't allocate unless more arguments than ever before are given.
+     *
+     * @param ctx    The parser context
+     */
+    void parser_reset(struct parser * ctx);
+
+    /*!
+     * @brief Values of a single parse run, kept apart from the parser
+     *
+     * The parser is only read while parsing into a result, thus any number of threads can parse concurrently with
+     * one parser as long as each thread uses its own result.
+     */
+    struct parse_result;
+
+    /*!
+     * @brief Creates a result for the given parser
+     *
+     * The first call prepares the lookup tables and help messages of the parser, thus it has to happen before the
+     * parser is shared between threads. Later calls only read the parser. The parser must not be modified afterwards,
+     * parsing fails if it was.
+     *
+     * @param parser The parser providing the argument definitions
+     * @return parse_result* Pointer to the result or NULL on failure
+     */
+    struct parse_result *parse_result_init(struct parser * parser);
+
+    /*!
+     * @brief Releases the result
+     *
+     * @param ctx    The result to free
+     */
+    void parse_result_deinit(struct parse_result * ctx);
+
+    /*!
+     * @brief Parsing of the given arguments into the result, the parser is not modified
+     *
+     * Values of the previous run are cleared, thus the result can be reused without allocation.
+     *
+     * @param ctx    The context containing the supported argument definitions
+     * @param result The result receiving the values, created for the same parser
+     * @param argv   The array of commandline arguments
+     * @param argc   Number of commandline arguments provided
+     * @return int   0 on success, 1 on failure.
+     */
+    int parser_parse_args_into(struct parser const *ctx, struct parse_result *result, char const *const *argv,
+                               int argc);
+
+    /*!
+     * @brief Returns how many times the flag was provided, or the number of values of a list
+     */
+    size_t parse_result_flag_count(struct parse_result const *ctx, struct flag const *flag);
+
+    /*!
+     * @brief Returns the value of the flag, NULL if not provided
+     */
+    char const *parse_result_flag_value_get(struct parse_result const *ctx, struct flag const *value);
+
+    /*!
+     * @brief Returns the values of the list, NULL if not provided
+     */
+    char const *const *parse_result_flag_list_get(struct parse_result const *ctx, struct flag const *list);
+
+    /*!
+     * @brief Returns the value of the argument, NULL if not provided
+     */
+    char const *parse_result_arg_value_get(struct parse_result const *ctx, struct arg const *value);
+
+    /*!
+     * @brief Returns the number of values of the argument list
+     */
+    size_t parse_result_arg_list_count(struct parse_result const *ctx, struct arg const *list);
+
+    /*!
+     * @brief Returns the values of the argument list, NULL if not provided
+     */
+    char const *const *parse_result_arg_list_get(struct parse_result const *ctx, struct arg const *list);
+
+    /*!
+     * @brief Delivers the values of the stream argument, see arg_stream_read(..)
+     */
+    int parse_result_arg_stream_read(struct parse_result const *ctx, struct arg const *stream, int fd, char delim,
+                                     arg_stream_fn fn, void *data);
+
+    /*!
+     * @brief Return whether the command is used
+     *
+     * @return int   1 if command is used, else 0
+     */
+    int parse_result_command_is_set(struct parse_result const *ctx, struct command const *cmd);
+
+    /*!
+     * @brief Commandline arguments with response files expanded
+     *
+     * Each argument '@file' is replaced by the arguments read from the file. These are separated by whitespace, may
+     * be quoted by single or double quotes and may name further response files. Regular files are mapped privately
+     * and tokenized in place, thus all values returned by the parser point into the mapping without being copied.
+     */
+    struct response_args;
+
+    /*!
+     * @brief Expands all response files given in argv, call response_args_deinit(..) to free it
+     *
+     * The name of the application (argv[0]) and arguments read from quoted names are never expanded. Errors are
+     * reported to stderr.
+     *
+     * @param argv                   The array of commandline arguments
+     * @param argc                   Number of commandline arguments provided
+     * @param limit                  Maximum size in bytes of all response files together, 0 if unlimited
+     * @return struct response_args* The expanded arguments or NULL on failure
+     */
+    struct response_args *response_args_init(char const *const *argv, int argc, size_t limit);
+
+    /*!
+     * @brief Releases the arguments, all values parsed from them become invalid
+     *
+     * @param ctx    The expanded arguments
+     */
+    void response_args_deinit(struct response_args * ctx);
+
+    /*!
+     * @brief Returns the array of expanded arguments, terminated by NULL same as argv of main
+     *
+     * @param ctx                     The expanded arguments
+     * @return char const* const*     The array passed to parser_parse_args(..)
+     */
+    char const *const *response_args_argv(struct response_args const *ctx);
+
+    /*!
+     * @brief Returns the number of expanded arguments
+     *
+     * @param ctx    The expanded arguments
+     * @return int   The count passed to parser_parse_args(..)
+     */
+    int response_args_argc(struct response_args const *ctx);
+
+    /*!
+     * @brief Statistics of a parser or result, only gathered if the library is built with ARGPARSE_STATS
+     *
+     * Timings are accumulated in nanoseconds, all values grow with each call. Without ARGPARSE_STATS all values
+     * stay zero and no instrumentation is compiled into the library.
+     */
+    struct parser_stats {
+        unsigned long long build_ns;    /*!< Adding flags, arguments and commands including duplicate checks */
+        unsigned long long classify_ns; /*!< Classification of the commandline arguments */
+        unsigned long long lookup_ns;   /*!< Lookup of flags and subcommands */
+        unsigned long long store_ns;    /*!< Storing of flag and argument values */
+        unsigned long long help_ns;     /*!< Output of help messages */
+        unsigned long long parse_ns;    /*!< Complete parse runs */
+        size_t tokens;                  /*!< Classified commandline arguments */
+        size_t comparisons;             /*!< String comparisons of names */
+        size_t nodes;                   /*!< Flags, arguments and commands created */
+        size_t bytes;                   /*!< Bytes taken from the arena */
+    };
+
+    /*!
+     * @brief Returns the statistics of building the parser and of parser_parse_args(..)
+     *
+     * @param ctx    The parser context
+     * @return parser_stats* Pointer to the statistics owned by the parser, NULL if ctx is NULL
+     */
+    struct parser_stats const *parser_get_stats(struct parser * ctx);
+
+    /*!
+     * @brief Returns the statistics of parser_parse_args_into(..) calls with this result
+     *
+     * @param ctx    The result
+     * @return parser_stats* Pointer to the statistics owned by the result, NULL if ctx is NULL
+     */
+    struct parser_stats const *parse_result_get_stats(struct parse_result * ctx);
+
 /*!
  * @brief See parser_init(..)
  */
@@ -345,6 +632,11 @@ extern C {
  */
 #define add_arg_list(parser, var, name, desc) struct arg *var = parser_add_arg_list(parser, name, desc)
 
+/*!
+ * @brief See parser_add_arg_stream(..)
+ */
+#define add_arg_stream(parser, var, name, desc) struct arg *var = parser_add_arg_stream(parser, name, desc)
+
 /*!
  * @brief See parser_add_command(..)
  */
@@ -379,6 +671,11 @@ extern C {
  */
 #define cmd_add_arg_list(cmd, var, name, desc) struct arg *var = command_add_arg_list(cmd, name, desc)
 
+/*!
+ * @brief See command_add_arg_stream(..)
+ */
+#define cmd_add_arg_stream(cmd, var, name, desc) struct arg *var = command_add_arg_stream(cmd, name, desc)
+
 /*!
  * @brief See command_add_command(..)
  */
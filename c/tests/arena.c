@@ -0,0 +1,112 @@
+#include "argparse.h"
+#include "check.h"
+
+#include <stddef.h>
+
+#define ARGC(argv) ((int)(sizeof(argv) / sizeof(argv[0])))
+
+/*!
+ * Flags, values and commands set by a run are cleared by parser_reset(..), thus the parser is reusable
+ */
+static void test_reset() {
+    parser_new(parser, "test", "Reset.", NULL);
+    add_flag(parser, verbose, 'v', "verbose", "Verbosity.");
+    add_flag_value(parser, output, 'o', "output", "PATH", "Output path.", SET_NONE);
+    add_command(parser, run, "run", "Run.", NULL);
+    cmd_add_arg_list(run, files, "FILES", "Files.");
+
+    char const *const first[] = {"test", "-vv", "-o", "out", "run", "a", "b"};
+    char const *const second[] = {"test", "-v"};
+    for (int i = 0; i < 3; ++i) {
+        CHECK(parser_parse_args(parser, first, ARGC(first)) == 0);
+        CHECK(flag_count(verbose) == 2);
+        CHECK_STR(flag_value_get(output), "out");
+        CHECK(command_is_set(run) == 1);
+        CHECK(arg_list_count(files) == 2);
+        parser_reset(parser);
+
+        CHECK(flag_count(verbose) == 0);
+        CHECK(flag_value_exists(output) == 0);
+        CHECK(command_is_set(run) == 0);
+        CHECK(arg_list_count(files) == 0);
+
+        CHECK(parser_parse_args(parser, second, ARGC(second)) == 0);
+        CHECK(flag_count(verbose) == 1);
+        CHECK(command_is_set(run) == 0);
+        parser_reset(parser);
+    }
+
+    // Without reset the command is processed twice, which fails
+    CHECK(parser_parse_args(parser, first, ARGC(first)) == 0);
+    CHECK(parser_parse_args(parser, first, ARGC(first)) != 0);
+    parser_deinit(parser);
+}
+
+/*!
+ * Blocks smaller than the tree result in multiple blocks, nodes larger than a block still get their own
+ */
+static void test_sized() {
+    struct parser *parser = parser_init_sized("test", "Sized.", NULL, 64);
+    CHECK(parser != NULL);
+    struct flag *flags[26];
+    char names[26][8];
+    for (int i = 0; i < 26; ++i) {
+        snprintf(names[i], sizeof(names[i]), "flag-%c", 'a' + i);
+        flags[i] = parser_add_flag(parser, (char)('a' + i), names[i], "Generated flag.");
+        CHECK(flags[i] != NULL);
+    }
+
+    char const *const argv[] = {"test", "-abc", "--flag-z", "-z"};
+    CHECK(parser_parse_args(parser, argv, ARGC(argv)) == 0);
+    CHECK(flag_count(flags[0]) == 1);
+    CHECK(flag_count(flags[2]) == 1);
+    CHECK(flag_count(flags[3]) == 0);
+    CHECK(flag_count(flags[25]) == 2);
+    parser_deinit(parser);
+}
+
+/*!
+ * A caller-owned buffer is used for all allocations, adding fails once it is exhausted
+ */
+static void test_static() {
+    static _Alignas(max_align_t) unsigned char tiny[16];
+    CHECK(parser_init_static("test", "Static.", NULL, tiny, sizeof(tiny)) == NULL);
+
+    static _Alignas(max_align_t) unsigned char buffer[8192];
+    struct parser *parser = parser_init_static("test", "Static.", NULL, buffer, sizeof(buffer));
+    CHECK(parser != NULL);
+    add_flag(parser, verbose, 'v', "verbose", "Verbosity.");
+    add_arg_list(parser, files, "FILES", "Files.");
+    CHECK(verbose != NULL && files != NULL);
+
+    char const *const argv[] = {"test", "-vv", "a", "b"};
+    for (int i = 0; i < 100; ++i) {
+        CHECK(parser_parse_args(parser, argv, ARGC(argv)) == 0);
+        CHECK(flag_count(verbose) == 2);
+        CHECK(arg_list_count(files) == 2);
+        parser_reset(parser);
+    }
+    parser_deinit(parser);
+
+    static _Alignas(max_align_t) unsigned char small[2048];
+    static char names[200][16];
+    parser = parser_init_static("test", "Static.", NULL, small, sizeof(small));
+    CHECK(parser != NULL);
+    int added = 0;
+    while (added < 200) {
+        snprintf(names[added], sizeof(names[added]), "flag-%d", added);
+        if (parser_add_flag(parser, (char)(added + 1), names[added], "Generated flag.") == NULL) {
+            break;
+        }
+        added += 1;
+    }
+    CHECK(added > 0 && added < 200);
+    parser_deinit(parser);
+}
+
+int main() {
+    test_reset();
+    test_sized();
+    test_static();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,37 @@
+#ifndef __ARGPARSE_C_CHECK__
+#define __ARGPARSE_C_CHECK__
+
+#include <stdio.h>
+#include <string.h>
+
+/*!
+ * Number of failed checks, each test returns it from main
+ */
+static int failures = 0;
+
+/*!
+ * Reports a failed condition and continues, thus a single run lists all failures of the test
+ */
+#define CHECK(cond)                                                                                                    \
+    do {                                                                                                               \
+        if (!(cond)) {                                                                                                 \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);                                   \
+            failures += 1;                                                                                             \
+        }                                                                                                              \
+    } while (0)
+
+/*!
+ * Compares two strings, either of them may be NULL
+ */
+#define CHECK_STR(actual, expected)                                                                                    \
+    do {                                                                                                               \
+        char const *a_ = (actual);                                                                                     \
+        char const *e_ = (expected);                                                                                   \
+        if ((a_ == NULL || e_ == NULL) ? a_ != e_ : strcmp(a_, e_) != 0) {                                             \
+            fprintf(stderr, "%s:%d: check failed: %s is '%s', expected '%s'\n", __FILE__, __LINE__, #actual,           \
+                    a_ == NULL ? "(null)" : a_, e_ == NULL ? "(null)" : e_);                                           \
+            failures += 1;                                                                                             \
+        }                                                                                                              \
+    } while (0)
+
+#endif // __ARGPARSE_C_CHECK__
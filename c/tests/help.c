@@ -0,0 +1,143 @@
+#include "argparse.h"
+#include "check.h"
+
+#include <ctype.h>
+
+#define DESC "A description that is long enough to be wrapped at least once or twice when the width is small."
+#define FOOTER "Footer text that also needs to be wrapped because it is long enough."
+#define VERBOSE "Verbosity flag with a description long enough to wrap with a hanging indent of its own."
+
+static char help[4096];
+
+/*!
+ * Length of the longest line of the message
+ */
+static size_t longest_line(char const *s) {
+    size_t longest = 0;
+    while (*s != '\0') {
+        size_t len = strcspn(s, "\n");
+        longest = len > longest ? len : longest;
+        s += len + (s[len] == '\n' ? 1 : 0);
+    }
+    return longest;
+}
+
+/*!
+ * Whether the words of the text are contained in order, independent of the line breaks
+ */
+static int contains_words(char const *s, char const *text) {
+    static char a[4096];
+    static char b[4096];
+    size_t n = 0;
+    for (; *s != '\0' && n < sizeof(a) - 1; ++s) {
+        if (!isspace((unsigned char)*s)) {
+            a[n++] = *s;
+        }
+    }
+    a[n] = '\0';
+    n = 0;
+    for (; *text != '\0' && n < sizeof(b) - 1; ++text) {
+        if (!isspace((unsigned char)*text)) {
+            b[n++] = *text;
+        }
+    }
+    b[n] = '\0';
+    return strstr(a, b) != NULL;
+}
+
+/*!
+ * Column of the first character of `word`, and of the first character of the following line
+ */
+static void columns_of(char const *s, char const *word, size_t *first, size_t *next) {
+    char const *at = strstr(s, word);
+    char const *line = at;
+    while (line > s && line[-1] != '\n') {
+        --line;
+    }
+    *first = at - line;
+    char const *following = strchr(at, '\n') + 1;
+    *next = strspn(following, " ");
+}
+
+static struct parser *make_parser() {
+    struct parser *parser = parser_init("test", DESC, FOOTER);
+    parser_add_flag(parser, 'v', "verbose", VERBOSE);
+    parser_add_flag_value(parser, 'o', "output", "PATH", "Output path.", SET_NONE);
+    return parser;
+}
+
+/*!
+ * Descriptions, footers and option descriptions are wrapped at word boundaries to the configured width
+ */
+static void test_wrap() {
+    struct parser *parser = make_parser();
+    parser_set_columns(parser, 60);
+    size_t len = parser_render_help(parser, help, sizeof(help));
+    CHECK(len == strlen(help));
+    CHECK(longest_line(help) <= 60);
+    CHECK(contains_words(help, DESC));
+    CHECK(contains_words(help, FOOTER));
+    CHECK(contains_words(help, VERBOSE));
+
+    // Option descriptions continue at the column of their first line
+    size_t first = 0;
+    size_t next = 0;
+    columns_of(help, "Verbosity", &first, &next);
+    CHECK(first > 0 && first == next);
+
+    // A wide terminal keeps the description on a single line
+    parser_set_columns(parser, 200);
+    parser_render_help(parser, help, sizeof(help));
+    CHECK(strstr(help, DESC) != NULL);
+    CHECK(strstr(help, VERBOSE) != NULL);
+    CHECK(longest_line(help) > 60);
+    parser_deinit(parser);
+}
+
+/*!
+ * Option descriptions keep at least 20 columns, thus a narrow width doesn't result in a word per line
+ */
+static void test_narrow() {
+    struct parser *parser = make_parser();
+    parser_set_columns(parser, 30);
+    parser_render_help(parser, help, sizeof(help));
+    CHECK(contains_words(help, VERBOSE));
+    CHECK(strstr(help, "Verbosity flag with") != NULL);
+
+    // Words longer than a line are never split
+    struct parser *words = parser_init("test", "Short supercalifragilisticexpialidocious words.", NULL);
+    parser_set_columns(words, 20);
+    parser_render_help(words, help, sizeof(help));
+    CHECK(strstr(help, "supercalifragilisticexpialidocious") != NULL);
+    parser_deinit(words);
+    parser_deinit(parser);
+}
+
+/*!
+ * The message is truncated like snprintf(..), the complete length is returned in any case
+ */
+static void test_truncate() {
+    struct parser *parser = make_parser();
+    parser_set_columns(parser, 60);
+    size_t len = parser_render_help(parser, help, sizeof(help));
+    CHECK(parser_render_help(parser, NULL, 0) == len);
+
+    char small[16];
+    memset(small, 'x', sizeof(small));
+    CHECK(parser_render_help(parser, small, sizeof(small)) == len);
+    CHECK(small[sizeof(small) - 1] == '\0');
+    CHECK(strncmp(small, help, sizeof(small) - 1) == 0);
+
+    // Rendering again gives the same message
+    char again[4096];
+    CHECK(parser_render_help(parser, again, sizeof(again)) == len);
+    CHECK_STR(again, help);
+    parser_deinit(parser);
+}
+
+int main() {
+    test_wrap();
+    test_narrow();
+    test_truncate();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+#include "argparse.h"
+#include "check.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#define ARGC(argv) ((int)(sizeof(argv) / sizeof(argv[0])))
+
+/*!
+ * Writes the content into a new file of the working directory, its name is stored in `name`
+ */
+static void write_file(char name[32], char const *content) {
+    strcpy(name, "response-XXXXXX");
+    int fd = mkstemp(name);
+    CHECK(fd != -1);
+    if (fd != -1) {
+        CHECK(write(fd, content, strlen(content)) == (ssize_t)strlen(content));
+        close(fd);
+    }
+}
+
+/*!
+ * Checks the expanded arguments against the expected ones, argv[0] included
+ */
+static void check_args(struct response_args const *args, char const *const *expected, int cnt) {
+    CHECK(args != NULL);
+    if (args == NULL) {
+        return;
+    }
+    CHECK(response_args_argc(args) == cnt);
+    char const *const *argv = response_args_argv(args);
+    for (int i = 0; i < cnt && i < response_args_argc(args); ++i) {
+        CHECK_STR(argv[i], expected[i]);
+    }
+    CHECK(argv[response_args_argc(args)] == NULL);
+}
+
+/*!
+ * Whitespace separates, quotes and escapes are removed, the file itself stays unchanged
+ */
+static void test_quoting() {
+    char const *content = "plain  'single quoted' \"double \\\"quoted\\\"\"\n"
+                          "es\\ caped \"a\\b\" 'it''s' mi\"x\"ed\t\\@literal \"@quoted\" '@single' @\n";
+    char name[32];
+    write_file(name, content);
+    char arg[40];
+    snprintf(arg, sizeof(arg), "@%s", name);
+
+    char const *const argv[] = {"@app", "before", arg, "after"};
+    struct response_args *args = response_args_init(argv, ARGC(argv), 0);
+    char const *const expected[] = {"@app",     "before",     "plain",   "single quoted", "double \"quoted\"",
+                                    "es caped", "a\\b",       "its",     "mixed",         "@literal",
+                                    "@quoted",  "@single",    "@",       "after"};
+    check_args(args, expected, ARGC(expected));
+
+    // The expanded arguments are parsed like argv of main
+    parser_new(parser, "test", "Response.", NULL);
+    add_arg_list(parser, values, "VALUES", "Values.");
+    CHECK(parser_parse_args(parser, response_args_argv(args), response_args_argc(args)) == 0);
+    CHECK(arg_list_count(values) == ARGC(expected) - 1);
+    CHECK_STR(arg_list_get(values)[2], "single quoted");
+    parser_deinit(parser);
+    response_args_deinit(args);
+
+    // The mapping is private, thus tokenizing in place doesn't modify the file
+    char buffer[256];
+    FILE *file = fopen(name, "r");
+    size_t len = file != NULL ? fread(buffer, 1, sizeof(buffer) - 1, file) : 0;
+    buffer[len] = '\0';
+    if (file != NULL) {
+        fclose(file);
+    }
+    CHECK_STR(buffer, content);
+    remove(name);
+}
+
+/*!
+ * Response files may name further response files, the nesting depth is limited
+ */
+static void test_nesting() {
+    char inner[32];
+    write_file(inner, "-v 'inner value'");
+    char outer_content[64];
+    snprintf(outer_content, sizeof(outer_content), "first @%s last", inner);
+    char outer[32];
+    write_file(outer, outer_content);
+
+    char arg[40];
+    snprintf(arg, sizeof(arg), "@%s", outer);
+    char const *const argv[] = {"app", arg};
+    struct response_args *args = response_args_init(argv, ARGC(argv), 0);
+    char const *const expected[] = {"app", "first", "-v", "inner value", "last"};
+    check_args(args, expected, ARGC(expected));
+    response_args_deinit(args);
+
+    // A file naming itself exceeds the depth, its name is only known once created
+    char self[32];
+    write_file(self, "");
+    FILE *file = fopen(self, "w");
+    if (file != NULL) {
+        fprintf(file, "x @%s", self);
+        fclose(file);
+    }
+    snprintf(arg, sizeof(arg), "@%s", self);
+    char const *const recursive[] = {"app", arg};
+    CHECK(response_args_init(recursive, ARGC(recursive), 0) == NULL);
+
+    remove(inner);
+    remove(outer);
+    remove(self);
+}
+
+/*!
+ * Missing files, unterminated quotes and files exceeding the limit fail the expansion
+ */
+static void test_failures() {
+    char const *const missing[] = {"app", "@response-missing"};
+    CHECK(response_args_init(missing, ARGC(missing), 0) == NULL);
+
+    char name[32];
+    write_file(name, "a 'unterminated");
+    char arg[40];
+    snprintf(arg, sizeof(arg), "@%s", name);
+    char const *const unterminated[] = {"app", arg};
+    CHECK(response_args_init(unterminated, ARGC(unterminated), 0) == NULL);
+    remove(name);
+
+    write_file(name, "0123456789 0123456789");
+    snprintf(arg, sizeof(arg), "@%s", name);
+    char const *const limited[] = {"app", arg};
+    CHECK(response_args_init(limited, ARGC(limited), 10) == NULL);
+    struct response_args *args = response_args_init(limited, ARGC(limited), 64);
+    char const *const expected[] = {"app", "0123456789", "0123456789"};
+    check_args(args, expected, ARGC(expected));
+    response_args_deinit(args);
+    remove(name);
+}
+
+int main() {
+    test_quoting();
+    test_nesting();
+    test_failures();
+    return failures == 0 ? 0 : 1;
+}
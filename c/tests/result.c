@@ -0,0 +1,115 @@
+#include "argparse.h"
+#include "check.h"
+
+#define ARGC(argv) ((int)(sizeof(argv) / sizeof(argv[0])))
+
+/*!
+ * Values are stored in the result, the parser itself stays untouched
+ */
+static void test_values() {
+    parser_new(parser, "test", "Result.", NULL);
+    add_flag(parser, verbose, 'v', "verbose", "Verbosity.");
+    add_flag_value(parser, output, 'o', "output", "PATH", "Output path.", SET_NONE);
+    add_flag_list(parser, list, 'l', "list", "VALUE", "Values.", SET_NONE);
+    add_command(parser, run, "run", "Run.", NULL);
+    cmd_add_arg_value(run, input, "INPUT", "Input path.");
+    cmd_add_arg_list(run, files, "FILES", "Files.");
+
+    struct parse_result *result = parse_result_init(parser);
+    CHECK(result != NULL);
+
+    char const *const argv[] = {"test", "-vv", "-o", "out", "-l", "a", "b", "run", "in", "x", "y", "z"};
+    CHECK(parser_parse_args_into(parser, result, argv, ARGC(argv)) == 0);
+    CHECK(parse_result_flag_count(result, verbose) == 2);
+    CHECK_STR(parse_result_flag_value_get(result, output), "out");
+    CHECK(parse_result_flag_count(result, list) == 2);
+    CHECK_STR(parse_result_flag_list_get(result, list)[1], "b");
+    CHECK(parse_result_command_is_set(result, run) == 1);
+    CHECK_STR(parse_result_arg_value_get(result, input), "in");
+    CHECK(parse_result_arg_list_count(result, files) == 3);
+    CHECK_STR(parse_result_arg_list_get(result, files)[2], "z");
+
+    CHECK(flag_count(verbose) == 0);
+    CHECK(flag_value_exists(output) == 0);
+    CHECK(command_is_set(run) == 0);
+
+    parse_result_deinit(result);
+    parser_deinit(parser);
+}
+
+/*!
+ * Each run clears the values of the previous one, results of the same parser are independent of each other
+ */
+static void test_reuse() {
+    parser_new(parser, "test", "Reuse.", NULL);
+    add_flag(parser, verbose, 'v', "verbose", "Verbosity.");
+    add_flag_value(parser, output, 'o', "output", "PATH", "Output path.", SET_NONE);
+    add_command(parser, run, "run", "Run.", NULL);
+
+    struct parse_result *first = parse_result_init(parser);
+    struct parse_result *second = parse_result_init(parser);
+    CHECK(first != NULL && second != NULL);
+
+    char const *const full[] = {"test", "-v", "-o", "out", "run"};
+    char const *const small[] = {"test", "-vvv"};
+    for (int i = 0; i < 3; ++i) {
+        CHECK(parser_parse_args_into(parser, first, full, ARGC(full)) == 0);
+        CHECK(parser_parse_args_into(parser, second, small, ARGC(small)) == 0);
+        CHECK(parse_result_flag_count(first, verbose) == 1);
+        CHECK_STR(parse_result_flag_value_get(first, output), "out");
+        CHECK(parse_result_command_is_set(first, run) == 1);
+        CHECK(parse_result_flag_count(second, verbose) == 3);
+        CHECK(parse_result_flag_value_get(second, output) == NULL);
+        CHECK(parse_result_command_is_set(second, run) == 0);
+
+        CHECK(parser_parse_args_into(parser, first, small, ARGC(small)) == 0);
+        CHECK(parse_result_flag_count(first, verbose) == 3);
+        CHECK(parse_result_flag_value_get(first, output) == NULL);
+        CHECK(parse_result_command_is_set(first, run) == 0);
+    }
+
+    // A failed run leaves no values of the previous one behind
+    char const *const unknown[] = {"test", "-x"};
+    CHECK(parser_parse_args_into(parser, first, unknown, ARGC(unknown)) != 0);
+    CHECK(parse_result_flag_count(first, verbose) == 0);
+
+    // The parser may still be used directly
+    CHECK(parser_parse_args(parser, full, ARGC(full)) == 0);
+    CHECK(flag_count(verbose) == 1);
+    CHECK(parse_result_flag_count(second, verbose) == 3);
+
+    parse_result_deinit(first);
+    parse_result_deinit(second);
+    parser_deinit(parser);
+}
+
+/*!
+ * Nodes added after creation of a result are unknown to it, thus parsing into it fails
+ */
+static void test_modified() {
+    parser_new(parser, "test", "Modified.", NULL);
+    add_flag(parser, verbose, 'v', "verbose", "Verbosity.");
+
+    struct parse_result *result = parse_result_init(parser);
+    CHECK(result != NULL);
+    add_flag(parser, quiet, 'q', "quiet", "Quiet.");
+
+    char const *const argv[] = {"test", "-v"};
+    CHECK(parser_parse_args_into(parser, result, argv, ARGC(argv)) != 0);
+    parse_result_deinit(result);
+
+    result = parse_result_init(parser);
+    char const *const both[] = {"test", "-vq"};
+    CHECK(parser_parse_args_into(parser, result, both, ARGC(both)) == 0);
+    CHECK(parse_result_flag_count(result, verbose) == 1);
+    CHECK(parse_result_flag_count(result, quiet) == 1);
+    parse_result_deinit(result);
+    parser_deinit(parser);
+}
+
+int main() {
+    test_values();
+    test_reuse();
+    test_modified();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+#include "argparse.h"
+#include "check.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#define ARGC(argv) ((int)(sizeof(argv) / sizeof(argv[0])))
+
+/*!
+ * Descriptor reading the given content, backed by an unlinked file thus any size can be provided
+ */
+static int input(char const *content, size_t len) {
+    char name[] = "stream-XXXXXX";
+    int fd = mkstemp(name);
+    CHECK(fd != -1);
+    if (fd != -1) {
+        CHECK(write(fd, content, len) == (ssize_t)len);
+        lseek(fd, 0, SEEK_SET);
+        remove(name);
+    }
+    return fd;
+}
+
+/*!
+ * Values received by the callback, joined by '|'
+ */
+struct received {
+    char joined[256];
+    int count;
+    int stop_after;
+};
+
+static int collect(char const *value, void *data) {
+    struct received *r = data;
+    size_t len = strlen(r->joined);
+    snprintf(r->joined + len, sizeof(r->joined) - len, "%s%s", len > 0 ? "|" : "", value);
+    r->count += 1;
+    return r->count == r->stop_after ? 7 : 0;
+}
+
+/*!
+ * Without values on the commandline, or with a single "-", the values are read from the descriptor
+ */
+static void test_read() {
+    parser_new(parser, "test", "Stream.", NULL);
+    add_flag(parser, verbose, 'v', "verbose", "Verbosity.");
+    add_arg_stream(parser, ids, "IDS", "Identifiers.");
+
+    char const *const none[] = {"test", "-v"};
+    CHECK(parser_parse_args(parser, none, ARGC(none)) == 0);
+    CHECK(flag_count(verbose) == 1);
+    int fd = input("a\nbb\n\n\nccc\nlast", 16);
+    struct received r = {{0}, 0, 0};
+    CHECK(arg_stream_read(ids, fd, '\n', collect, &r) == 0);
+    CHECK_STR(r.joined, "a|bb|ccc|last");
+    close(fd);
+    parser_reset(parser);
+
+    char const *const dash[] = {"test", "-"};
+    CHECK(parser_parse_args(parser, dash, ARGC(dash)) == 0);
+    fd = input("x\0y\0", 4);
+    memset(&r, 0, sizeof(r));
+    CHECK(arg_stream_read(ids, fd, '\0', collect, &r) == 0);
+    CHECK_STR(r.joined, "x|y");
+    close(fd);
+    parser_reset(parser);
+
+    // Values on the commandline are delivered instead of reading the descriptor
+    char const *const given[] = {"test", "1", "2"};
+    CHECK(parser_parse_args(parser, given, ARGC(given)) == 0);
+    memset(&r, 0, sizeof(r));
+    CHECK(arg_stream_read(ids, -1, '\n', collect, &r) == 0);
+    CHECK_STR(r.joined, "1|2");
+    parser_deinit(parser);
+}
+
+/*!
+ * The callback stops reading by returning non-zero, values of more than 64 KiB and unreadable descriptors fail
+ */
+static void test_stop() {
+    parser_new(parser, "test", "Stream.", NULL);
+    add_arg_stream(parser, ids, "IDS", "Identifiers.");
+    char const *const none[] = {"test"};
+    CHECK(parser_parse_args(parser, none, ARGC(none)) == 0);
+
+    int fd = input("1\n2\n3\n", 6);
+    struct received r = {{0}, 0, 2};
+    CHECK(arg_stream_read(ids, fd, '\n', collect, &r) == 7);
+    CHECK_STR(r.joined, "1|2");
+    close(fd);
+
+    size_t len = 70 * 1024;
+    char *large = malloc(len);
+    CHECK(large != NULL);
+    if (large != NULL) {
+        memset(large, 'x', len);
+        fd = input(large, len);
+        memset(&r, 0, sizeof(r));
+        CHECK(arg_stream_read(ids, fd, '\n', collect, &r) == -1);
+        close(fd);
+        free(large);
+    }
+    CHECK(arg_stream_read(ids, -1, '\n', collect, &r) == -1);
+    parser_deinit(parser);
+}
+
+/*!
+ * Streams of a result are read the same way
+ */
+static void test_result() {
+    parser_new(parser, "test", "Stream.", NULL);
+    add_arg_stream(parser, ids, "IDS", "Identifiers.");
+    struct parse_result *result = parse_result_init(parser);
+
+    char const *const given[] = {"test", "5"};
+    CHECK(parser_parse_args_into(parser, result, given, ARGC(given)) == 0);
+    struct received r = {{0}, 0, 0};
+    CHECK(parse_result_arg_stream_read(result, ids, -1, '\n', collect, &r) == 0);
+    CHECK_STR(r.joined, "5");
+
+    char const *const none[] = {"test"};
+    CHECK(parser_parse_args_into(parser, result, none, ARGC(none)) == 0);
+    int fd = input("6\n7\n", 4);
+    memset(&r, 0, sizeof(r));
+    CHECK(parse_result_arg_stream_read(result, ids, fd, '\n', collect, &r) == 0);
+    CHECK_STR(r.joined, "6|7");
+    close(fd);
+
+    parse_result_deinit(result);
+    parser_deinit(parser);
+}
+
+int main() {
+    test_read();
+    test_stop();
+    test_result();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+#include "argparse.h"
+#include "check.h"
+
+#define ARGC(argv) ((int)(sizeof(argv) / sizeof(argv[0])))
+
+/*!
+ * A single "-" is a plain word, e.g. the common name of stdin, and never a flag
+ */
+static void test_lone_dash() {
+    parser_new(parser, "test", "Lone dash.", NULL);
+    add_flag_value(parser, output, 'o', "output", "PATH", "Output path.", SET_NONE);
+    add_arg_value(parser, input, "INPUT", "Input path.");
+
+    char const *const argv[] = {"test", "-"};
+    CHECK(parser_parse_args(parser, argv, ARGC(argv)) == 0);
+    CHECK(flag_value_exists(output) == 0);
+    CHECK_STR(arg_value_get(input), "-");
+    parser_reset(parser);
+
+    char const *const with_value[] = {"test", "-o", "-", "-"};
+    CHECK(parser_parse_args(parser, with_value, ARGC(with_value)) == 0);
+    CHECK_STR(flag_value_get(output), "-");
+    CHECK_STR(arg_value_get(input), "-");
+    parser_deinit(parser);
+}
+
+/*!
+ * Arguments following "--" are positional even if they look like flags
+ */
+static void test_separator() {
+    parser_new(parser, "test", "Separator.", NULL);
+    add_flag(parser, verbose, 'v', "verbose", "Verbosity.");
+    add_arg_list(parser, files, "FILES", "Files.");
+
+    char const *const argv[] = {"test", "-v", "--", "-v", "--verbose"};
+    CHECK(parser_parse_args(parser, argv, ARGC(argv)) == 0);
+    CHECK(flag_count(verbose) == 1);
+    CHECK(arg_list_count(files) == 2);
+    CHECK_STR(arg_list_get(files)[0], "-v");
+    CHECK_STR(arg_list_get(files)[1], "--verbose");
+    parser_deinit(parser);
+}
+
+/*!
+ * Combined short flags count each flag, a value list ends at the next flag or subcommand
+ */
+static void test_boundaries() {
+    parser_new(parser, "test", "Boundaries.", NULL);
+    add_flag(parser, verbose, 'v', "verbose", "Verbosity.");
+    add_flag_list(parser, list, 'l', "list", "VALUE", "Values.", SET_NONE);
+    add_command(parser, run, "run", "Run.", NULL);
+    cmd_add_arg_value(run, input, "INPUT", "Input path.");
+
+    char const *const argv[] = {"test", "-vvv", "-l", "a", "b", "-v", "run", "x"};
+    CHECK(parser_parse_args(parser, argv, ARGC(argv)) == 0);
+    CHECK(flag_count(verbose) == 4);
+    CHECK(flag_list_count(list) == 2);
+    CHECK_STR(flag_list_get(list)[1], "b");
+    CHECK(command_is_set(run) == 1);
+    CHECK_STR(arg_value_get(input), "x");
+    parser_reset(parser);
+
+    // The values of a list are contiguous in argv, thus it can't be given twice
+    char const *const twice[] = {"test", "-l", "a", "-l", "b"};
+    CHECK(parser_parse_args(parser, twice, ARGC(twice)) != 0);
+    parser_deinit(parser);
+}
+
+/*!
+ * Unknown flags and missing positionals fail the parse run
+ */
+static void test_failures() {
+    parser_new(parser, "test", "Failures.", NULL);
+    add_flag(parser, verbose, 'v', "verbose", "Verbosity.");
+    add_arg_value(parser, input, "INPUT", "Input path.");
+
+    char const *const unknown[] = {"test", "-x", "in"};
+    CHECK(parser_parse_args(parser, unknown, ARGC(unknown)) != 0);
+    parser_reset(parser);
+
+    char const *const missing[] = {"test", "-v"};
+    CHECK(parser_parse_args(parser, missing, ARGC(missing)) != 0);
+    parser_reset(parser);
+
+    // The parser stays usable after a failed run
+    char const *const valid[] = {"test", "-v", "in"};
+    CHECK(parser_parse_args(parser, valid, ARGC(valid)) == 0);
+    CHECK(flag_count(verbose) == 1);
+    CHECK_STR(arg_value_get(input), "in");
+    parser_deinit(parser);
+}
+
+int main() {
+    test_lone_dash();
+    test_separator();
+    test_boundaries();
+    test_failures();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,84 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "argparse.hxx"
+
+// Runs of each input size, the best one is reported to filter out noise
+static constexpr int REPEAT = 5;
+
+// Maximum tolerated growth of the time per argument between the smallest and largest input
+static constexpr double LINEAR_TOLERANCE = 4.0;
+
+// Arguments are the prefix followed by `cnt` times the item, an empty item is replaced by unique paths
+struct scenario {
+    std::string_view name;
+    std::vector<std::string> prefix;
+    std::string item;
+};
+
+static auto make_args(size_t cnt, scenario const &s) -> std::vector<std::string> {
+    auto args = std::vector<std::string>{"bench"};
+    args.reserve(cnt + s.prefix.size() + 1);
+    args.insert(args.end(), s.prefix.begin(), s.prefix.end());
+    for (size_t i = 0; i < cnt; ++i) {
+        args.push_back(s.item.empty() ? "/data/shard/" + std::to_string(i) : s.item);
+    }
+    return args;
+}
+
+// Returns the best time in nanoseconds per argument of multiple runs
+static auto run(size_t cnt, scenario const &s) -> double {
+    auto args = make_args(cnt, s);
+    auto argv = std::vector<char *>();
+    argv.reserve(args.size());
+    for (auto &a : args) {
+        argv.push_back(a.data());
+    }
+
+    auto best = -1.0;
+    for (int r = 0; r < REPEAT; ++r) {
+        auto parser = argparse::parser("bench", "Benchmark of the argument parsing.");
+        parser.add_opt_flag('v', "verbose", "Verbosity flag.");
+        parser.add_opt_list<std::string>('l', "list", "List of values.");
+
+        auto start = std::chrono::steady_clock::now();
+        auto ok = parser.parse(static_cast<int>(argv.size()), argv.data());
+        auto stop = std::chrono::steady_clock::now();
+
+        if (!ok) {
+            std::cerr << "Parsing of " << cnt << " arguments failed." << std::endl;
+            exit(1);
+        }
+        auto elapsed = std::chrono::duration<double, std::nano>(stop - start).count();
+        if (best < 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best / static_cast<double>(argv.size());
+}
+
+int main() {
+    auto scenarios = std::vector<scenario>{
+        {"option-list", {"-v", "-l"}, ""},
+        {"flags", {}, "-v"},
+    };
+
+    auto failed = false;
+    for (auto &s : scenarios) {
+        auto base = -1.0;
+        for (size_t cnt : {10000, 100000, 1000000}) {
+            auto per_arg = run(cnt, s);
+            std::cout << s.name << " " << cnt << " args: " << per_arg << " ns/arg" << std::endl;
+            if (base < 0) {
+                base = per_arg;
+            } else if (per_arg > base * LINEAR_TOLERANCE) {
+                std::cerr << s.name << " parse time grows faster than linear." << std::endl;
+                failed = true;
+            }
+        }
+    }
+
+    return failed ? 1 : 0;
+}
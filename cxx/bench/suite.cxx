@@ -0,0 +1,362 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "argparse.hxx"
+#include "schema.hxx"
+
+// Short flags are single bytes, thus the number of flags per command is limited
+static constexpr int MAX_OPTIONS = 250;
+static constexpr int MAX_DEPTH = 8;
+static constexpr int MAX_ARGC = 1000000;
+static constexpr int REPEAT = 5;
+
+// Small inputs are parsed repeatedly until at least this many arguments are processed per measurement
+static constexpr long MIN_WORK = 1000000;
+
+// Same options as make_parser(16, 0), defined at compile time
+using schema_cli = argparse::schema::command<
+    "bench", "Benchmark of the argument parsing.",
+    argparse::schema::flag<1, "option-0", "Generated flag.">,
+    argparse::schema::flag<2, "option-1", "Generated flag.">,
+    argparse::schema::flag<3, "option-2", "Generated flag.">,
+    argparse::schema::flag<4, "option-3", "Generated flag.">,
+    argparse::schema::flag<5, "option-4", "Generated flag.">,
+    argparse::schema::flag<6, "option-5", "Generated flag.">,
+    argparse::schema::flag<7, "option-6", "Generated flag.">,
+    argparse::schema::flag<8, "option-7", "Generated flag.">,
+    argparse::schema::flag<9, "option-8", "Generated flag.">,
+    argparse::schema::flag<10, "option-9", "Generated flag.">,
+    argparse::schema::flag<11, "option-10", "Generated flag.">,
+    argparse::schema::flag<12, "option-11", "Generated flag.">,
+    argparse::schema::flag<13, "option-12", "Generated flag.">,
+    argparse::schema::flag<14, "option-13", "Generated flag.">,
+    argparse::schema::flag<15, "option-14", "Generated flag.">,
+    argparse::schema::flag<16, "option-15", "Generated flag.">,
+    argparse::schema::list<std::string_view, static_cast<char>(MAX_OPTIONS + 1), "list", "List of values.">>;
+
+// Discards everything, used to measure help rendering without terminal output
+class null_buffer : public std::streambuf {
+  protected:
+    auto overflow(int c) -> int override { return c; }
+    auto xsputn(char const * /*s*/, std::streamsize n) -> std::streamsize override { return n; }
+};
+
+class suite {
+  public:
+    suite(std::ostream &out, bool json) : _out(out), _json(json) {
+        for (int i = 0; i < MAX_OPTIONS; ++i) {
+            _names.push_back("option-" + std::to_string(i));
+            _longs.push_back("--" + _names.back());
+        }
+        for (int i = 0; i < MAX_DEPTH; ++i) {
+            _levels.push_back("level-" + std::to_string(i + 1));
+        }
+        for (int i = 0; i < MAX_ARGC; ++i) {
+            _values.push_back("/data/shard/" + std::to_string(i));
+            _ids.push_back(std::to_string(i * 7919U));
+        }
+
+        // Combined short flags with 15 flags each
+        _bundle = "-";
+        for (int i = 1; i < 16; ++i) {
+            _bundle += static_cast<char>(i * 7 % MAX_OPTIONS + 1);
+        }
+    }
+
+    auto run() -> void {
+        if (_json) {
+            _out << "{\n  \"library\": \"argparse-cxx\",\n  \"results\": [";
+        } else {
+            _out << "library,scenario,parameter,value,argc,iterations,ns_per_parse,ns_per_arg" << std::endl;
+        }
+
+        bench_argc();
+        bench_options();
+        bench_depth();
+        bench_bundles();
+        bench_lists();
+        bench_numbers();
+        bench_direct();
+        bench_positionals();
+        bench_schema();
+        bench_help();
+
+        if (_json) {
+            _out << "\n  ]\n}" << std::endl;
+        }
+    }
+
+  private:
+    std::ostream &_out;
+    bool _json;
+    int _rows = 0;
+
+    std::vector<std::string> _names;
+    std::vector<std::string> _longs;
+    std::vector<std::string> _levels;
+    std::vector<std::string> _values;
+    std::vector<std::string> _ids;
+    std::string _bundle;
+
+    // Creates a parser with a chain of `depth` subcommands, each command has `options` flags and a value list
+    auto make_parser(int options, int depth) -> std::unique_ptr<argparse::parser> {
+        auto parser = std::make_unique<argparse::parser>("bench", "Benchmark of the argument parsing.");
+        argparse::command *cmd = parser.get();
+        for (int d = 0; d <= depth; ++d) {
+            if (d > 0) {
+                cmd = &cmd->add_command(_levels[d - 1], "Generated command.");
+            }
+            for (int i = 0; i < options; ++i) {
+                cmd->add_opt_flag(static_cast<char>(i + 1), _names[i], "Generated flag.");
+            }
+        }
+        cmd->add_opt_list<std::string>(static_cast<char>(MAX_OPTIONS + 1), "list", "List of values.");
+        return parser;
+    }
+
+    auto report(std::string_view scenario, std::string_view parameter, long value, size_t argc, long iterations,
+                double ns) -> void {
+        auto per_arg = ns / static_cast<double>(argc);
+        if (_json) {
+            _out << (_rows == 0 ? "" : ",") << "\n    {\"scenario\": \"" << scenario << "\", \"parameter\": \""
+                 << parameter << "\", \"value\": " << value << ", \"argc\": " << argc
+                 << ", \"iterations\": " << iterations << ", \"ns_per_parse\": " << ns
+                 << ", \"ns_per_arg\": " << per_arg << "}";
+        } else {
+            _out << "argparse-cxx," << scenario << "," << parameter << "," << value << "," << argc << ","
+                 << iterations << "," << ns << "," << per_arg << std::endl;
+        }
+        _rows += 1;
+    }
+
+    // Returns the best time in nanoseconds per parse of multiple runs, the result is reused by all parses
+    static auto measure(argparse::parser const &parser, std::vector<char *> &argv, long iterations, bool expect)
+        -> double {
+        auto result = argparse::result();
+        auto argc = static_cast<int>(argv.size());
+        auto best = -1.0;
+        for (int r = 0; r < REPEAT; ++r) {
+            auto start = std::chrono::steady_clock::now();
+            for (long i = 0; i < iterations; ++i) {
+                if (parser.parse(argc, argv.data(), result) != expect) {
+                    std::cerr << "Parsing of " << argc << " arguments failed." << std::endl;
+                    exit(1);
+                }
+            }
+            auto stop = std::chrono::steady_clock::now();
+            auto ns = std::chrono::duration<double, std::nano>(stop - start).count();
+            if (best < 0 || ns < best) {
+                best = ns;
+            }
+        }
+        return best / static_cast<double>(iterations);
+    }
+
+    // Same as measure, but the values are stored into the arguments themselves, the parser is reset before each parse
+    static auto measure_direct(argparse::parser &parser, std::vector<char *> &argv, long iterations) -> double {
+        auto argc = static_cast<int>(argv.size());
+        auto best = -1.0;
+        for (int r = 0; r < REPEAT; ++r) {
+            auto start = std::chrono::steady_clock::now();
+            for (long i = 0; i < iterations; ++i) {
+                parser.reset();
+                if (!parser.parse(argc, argv.data())) {
+                    std::cerr << "Parsing of " << argc << " arguments failed." << std::endl;
+                    exit(1);
+                }
+            }
+            auto stop = std::chrono::steady_clock::now();
+            auto ns = std::chrono::duration<double, std::nano>(stop - start).count();
+            if (best < 0 || ns < best) {
+                best = ns;
+            }
+        }
+        return best / static_cast<double>(iterations);
+    }
+
+    auto run(std::string_view scenario, std::string_view parameter, long value, argparse::parser const &parser,
+             std::vector<char *> &argv) -> void {
+        long argc = static_cast<long>(argv.size());
+        long iterations = argc >= MIN_WORK ? 1 : MIN_WORK / argc;
+        report(scenario, parameter, value, argv.size(), iterations, measure(parser, argv, iterations, true));
+    }
+
+    static auto make_args(std::vector<std::string> &items) -> std::vector<char *> {
+        auto argv = std::vector<char *>();
+        argv.reserve(items.size());
+        for (auto &i : items) {
+            argv.push_back(i.data());
+        }
+        return argv;
+    }
+
+    auto bench_argc() -> void {
+        auto parser = make_parser(16, 0);
+        for (int n = 10; n <= MAX_ARGC; n *= 10) {
+            auto items = std::vector<std::string>{"bench"};
+            for (int i = 0; i < n; ++i) {
+                items.push_back(_longs[i % 16]);
+            }
+            auto argv = make_args(items);
+            run("long-flags", "argc", n, *parser, argv);
+        }
+    }
+
+    auto bench_options() -> void {
+        for (int cnt : {1, 10, 50, 100, MAX_OPTIONS}) {
+            auto parser = make_parser(cnt, 0);
+            auto items = std::vector<std::string>{"bench"};
+            for (int i = 0; i < 1000; ++i) {
+                items.push_back(_longs[(i * 7) % cnt]);
+            }
+            auto argv = make_args(items);
+            run("lookup", "options", cnt, *parser, argv);
+        }
+    }
+
+    auto bench_depth() -> void {
+        for (int d = 1; d <= MAX_DEPTH; ++d) {
+            auto parser = make_parser(16, d);
+            auto items = std::vector<std::string>{"bench"};
+            items.insert(items.end(), _levels.begin(), _levels.begin() + d);
+            items.push_back(_longs[0]);
+            auto argv = make_args(items);
+            run("subcommands", "depth", d, *parser, argv);
+        }
+    }
+
+    auto bench_bundles() -> void {
+        auto parser = make_parser(MAX_OPTIONS, 0);
+        for (int n = 10; n <= MAX_ARGC; n *= 10) {
+            auto items = std::vector<std::string>(n + 1, _bundle);
+            items[0] = "bench";
+            auto argv = make_args(items);
+            run("short-bundles", "argc", n, *parser, argv);
+        }
+    }
+
+    auto bench_lists() -> void {
+        auto parser = make_parser(16, 0);
+        for (int n = 10; n <= MAX_ARGC; n *= 10) {
+            auto items = std::vector<std::string>{"bench", "--list"};
+            items.insert(items.end(), _values.begin(), _values.begin() + n);
+            auto argv = make_args(items);
+            run("option-list", "argc", n, *parser, argv);
+        }
+    }
+
+    auto bench_numbers() -> void {
+        auto parser = make_parser(16, 0);
+        parser->add_opt_list<uint32_t>(static_cast<char>(MAX_OPTIONS + 2), "ids", "List of ids.");
+        for (int n = 10; n <= MAX_ARGC; n *= 10) {
+            auto items = std::vector<std::string>{"bench", "--ids"};
+            items.insert(items.end(), _ids.begin(), _ids.begin() + n);
+            auto argv = make_args(items);
+            run("number-list", "argc", n, *parser, argv);
+        }
+    }
+
+    auto bench_direct() -> void {
+        auto parser = make_parser(MAX_OPTIONS, 0);
+        for (int n = 10; n <= MAX_ARGC; n *= 10) {
+            auto items = std::vector<std::string>{"bench"};
+            for (int i = 0; i < n; ++i) {
+                items.push_back(i % 2 == 0 ? _longs[i % 16] : _bundle);
+            }
+            auto argv = make_args(items);
+            long iterations = n >= MIN_WORK ? 1 : MIN_WORK / n;
+            report("direct-flags", "argc", n, argv.size(), iterations, measure_direct(*parser, argv, iterations));
+        }
+    }
+
+    auto bench_positionals() -> void {
+        auto parser = make_parser(16, 0);
+        auto &id = parser->add_req_value<uint32_t>("ID", "Id of the job.");
+        auto &files = parser->add_req_list<std::string_view>("FILES", "List of files.");
+        for (int n = 10; n <= MAX_ARGC; n *= 10) {
+            auto items = std::vector<std::string>{"bench", _ids[n % MAX_ARGC]};
+            items.insert(items.end(), _values.begin(), _values.begin() + n);
+            auto argv = make_args(items);
+            long iterations = n >= MIN_WORK ? 1 : MIN_WORK / n;
+            auto ns = measure_direct(*parser, argv, iterations);
+            if (id.get_value() == nullptr || files.get_values().size() != static_cast<size_t>(n)) {
+                std::cerr << "Positional arguments of " << argv.size() << " arguments missing." << std::endl;
+                exit(1);
+            }
+            report("positionals", "argc", n, argv.size(), iterations, ns);
+        }
+    }
+
+    auto bench_schema() -> void {
+        auto result = schema_cli::result();
+        for (int n = 10; n <= MAX_ARGC; n *= 10) {
+            auto items = std::vector<std::string>{"bench"};
+            for (int i = 0; i < n; ++i) {
+                items.push_back(_longs[i % 16]);
+            }
+            auto argv = make_args(items);
+            auto argc = static_cast<int>(argv.size());
+            long iterations = n >= MIN_WORK ? 1 : MIN_WORK / n;
+
+            auto best = -1.0;
+            for (int r = 0; r < REPEAT; ++r) {
+                auto start = std::chrono::steady_clock::now();
+                for (long i = 0; i < iterations; ++i) {
+                    if (!schema_cli::parse(argc, argv.data(), result)) {
+                        std::cerr << "Parsing of " << argc << " arguments failed." << std::endl;
+                        exit(1);
+                    }
+                }
+                auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+                if (best < 0 || ns < best) {
+                    best = ns;
+                }
+            }
+            report("schema-long-flags", "argc", n, argv.size(), iterations, best / static_cast<double>(iterations));
+        }
+    }
+
+    auto bench_help() -> void {
+        auto items = std::vector<std::string>{"bench", "-h"};
+        auto argv = make_args(items);
+        auto discard = null_buffer();
+
+        for (int cnt : {1, 10, 50, 100, MAX_OPTIONS}) {
+            auto parser = make_parser(cnt, 0);
+            long iterations = 1000;
+
+            // Help is written to std::cout, discard it during the measurement
+            auto *buf = std::cout.rdbuf(&discard);
+            auto ns = measure(*parser, argv, iterations, false);
+            std::cout.rdbuf(buf);
+
+            report("help", "options", cnt, argv.size(), iterations, ns);
+        }
+    }
+};
+
+int main(int argc, char *argv[]) {
+    auto cli = argparse::parser(argv[0], "Benchmark suite of argparse-cxx. Results are written as CSV or JSON.");
+    auto &format = cli.add_opt_value<std::string>('f', "format", "Output format, csv or json.");
+    auto &output = cli.add_opt_value<std::string>('o', "output", "Write results to file.");
+    if (!cli.parse(argc, argv)) {
+        return 1;
+    }
+
+    auto json = format.get_value() != nullptr && *format.get_value() == "json";
+    if (output.get_value() != nullptr) {
+        auto file = std::ofstream(*output.get_value());
+        if (!file) {
+            std::cerr << "Unable to open output file." << std::endl;
+            return 1;
+        }
+        suite(file, json).run();
+    } else {
+        suite(std::cout, json).run();
+    }
+    return 0;
+}
@@ -0,0 +1,35 @@
+#include <iostream>
+
+#include "schema.hxx"
+
+namespace schema = argparse::schema;
+
+// The whole CLI is defined at compile time, duplicated names fail to compile
+using cli = schema::command<"schema", "Example application with a CLI defined at compile time.",
+                            schema::flag<'v', "verbose", "Enable verbosity level. Allows multiple occurrences.">,
+                            schema::value<std::chrono::milliseconds, 't', "timeout", "Timeout, e.g. 250ms or 2s.">,
+                            schema::command<"run", "Run the given files.",
+                                            schema::list<uint32_t, 's', "shards", "Ids of the shards to use.">,
+                                            schema::args<std::string_view, "FILES", "Files to run.">>>;
+
+int main(int argc, char *argv[]) {
+    auto res = cli::result();
+    if (!cli::parse(argc, argv, res)) {
+        return 1;
+    }
+
+    std::cerr << "Flag count?   " << res.get<"verbose">() << std::endl;
+    if (res.get<"timeout">().has_value()) {
+        std::cerr << "Timeout?      " << res.get<"timeout">()->count() << "ms" << std::endl;
+    }
+
+    auto const &run = res.get<"run">();
+    if (run.set) {
+        std::cerr << "Shards?       " << run.get<"shards">().size() << std::endl;
+        for (auto file : run.get<"FILES">()) {
+            std::cerr << "File:         " << file << std::endl;
+        }
+    }
+
+    return 0;
+}
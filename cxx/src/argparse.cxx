@@ -22,25 +22,349 @@
  * SOFTWARE.
  *********************************************************************************************************************/
 
-#include <iomanip>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <mutex>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ARGPARSE_POSIX
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define ARGPARSE_SIMD_X86
+#endif
 
 #include "argparse.hxx"
 
 /*********************************************************************************************************************
- * argparse::parse specializations
+ * argparse::converter implementation
  *********************************************************************************************************************/
 
-template <> auto argparse::parse(char const *const s) -> int { return atoi(s); }
+namespace {
+
+// Compares ASCII case-insensitive, the expected value is lower case
+auto equals_lower(std::string_view s, std::string_view expected) -> bool {
+    return s.size() == expected.size() && std::ranges::equal(s, expected, [](char a, char b) -> bool {
+               return (a >= 'A' && a <= 'Z' ? static_cast<char>(a - 'A' + 'a') : a) == b;
+           });
+}
+
+// Splits the leading number from its suffix, returns false if there is no number
+auto split_number(std::string_view s, long double &number, std::string_view &suffix) -> bool {
+    auto const *end = s.data() + s.size();
+    auto [ptr, ec] = std::from_chars(s.data(), end, number, std::chars_format::fixed);
+    if (ec != std::errc() || ptr == s.data()) {
+        return false;
+    }
+    suffix = std::string_view(ptr, end - ptr);
+    return true;
+}
+
+auto parse_digits_scalar(std::string_view s, uint64_t &value) -> bool {
+    auto v = uint64_t(0);
+    for (auto c : s) {
+        auto d = static_cast<unsigned char>(c - '0');
+        if (d > 9) {
+            return false;
+        }
+        v = v * 10 + d;
+    }
+    value = v;
+    return true;
+}
+
+#ifdef ARGPARSE_SIMD_X86
+auto const has_sse41 = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.1") != 0;
+}();
+
+/*!
+ * Validates and converts up to 16 digits at once. The digits are copied right aligned into a buffer of 16 '0', thus
+ * the load never reads outside of the string and the leading zeros do not change the value.
+ */
+__attribute__((target("sse4.1"))) auto parse_digits_sse41(std::string_view s, uint64_t &value) -> bool {
+    auto const len = s.size();
+    if (len > 16) {
+        return parse_digits_scalar(s, value);
+    }
+
+    alignas(16) char buffer[16];
+    std::memset(buffer, '0', sizeof(buffer));
+    std::memcpy(buffer + sizeof(buffer) - len, s.data(), len);
+    auto const chars = _mm_load_si128(reinterpret_cast<__m128i const *>(buffer));
+    auto const digits = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+
+    // Digits are 0..9 as unsigned bytes, any other character wraps around to a larger value
+    auto const nine = _mm_set1_epi8(9);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(digits, nine), nine)) != 0xffff) {
+        return false;
+    }
+
+    // Combine pairs of digits, then groups of 4 and 8 digits
+    auto const pairs = _mm_maddubs_epi16(digits, _mm_set1_epi16(0x010a));
+    auto const quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00010064));
+    auto const octs = _mm_madd_epi16(_mm_packus_epi32(quads, quads), _mm_set1_epi32(0x00012710));
+    auto const hi = static_cast<uint64_t>(static_cast<uint32_t>(_mm_cvtsi128_si32(octs)));
+    auto const lo = static_cast<uint64_t>(static_cast<uint32_t>(_mm_extract_epi32(octs, 1)));
+    value = hi * 100000000 + lo;
+    return true;
+}
+#endif
+
+} // namespace
+
+auto argparse::parse_digits(std::string_view s, uint64_t &value) -> bool {
+    if (s.empty() || s.size() > 19) {
+        return false;
+    }
+#ifdef ARGPARSE_SIMD_X86
+    if (has_sse41) {
+        return parse_digits_sse41(s, value);
+    }
+#endif
+    return parse_digits_scalar(s, value);
+}
+
+auto argparse::converter<bool>::convert(std::string_view s, bool &value) -> bool {
+    for (auto t : {"true", "yes", "on", "1"}) {
+        if (equals_lower(s, t)) {
+            value = true;
+            return true;
+        }
+    }
+    for (auto f : {"false", "no", "off", "0"}) {
+        if (equals_lower(s, f)) {
+            value = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+auto argparse::parse_duration(std::string_view s, long double unit,
+                              std::chrono::duration<long double, std::nano> &value) -> bool {
+    static constexpr std::array<std::pair<std::string_view, long double>, 6> units = {{
+        {"ns", 1.0L},
+        {"us", 1e3L},
+        {"ms", 1e6L},
+        {"s", 1e9L},
+        {"min", 60e9L},
+        {"h", 3600e9L},
+    }};
+
+    auto number = 0.0L;
+    auto suffix = std::string_view();
+    if (!split_number(s, number, suffix)) {
+        return false;
+    }
+    if (!suffix.empty()) {
+        auto it = std::ranges::find(units, suffix, &std::pair<std::string_view, long double>::first);
+        if (it == units.end()) {
+            return false;
+        }
+        unit = it->second;
+    }
+    value = std::chrono::duration<long double, std::nano>(number * unit);
+    return true;
+}
+
+auto argparse::converter<argparse::byte_size>::convert(std::string_view s, byte_size &value) -> bool {
+    static constexpr std::array<std::pair<std::string_view, uint64_t>, 14> units = {{
+        {"b", 1ULL},
+        {"k", 1ULL << 10},
+        {"kib", 1ULL << 10},
+        {"kb", 1000ULL},
+        {"m", 1ULL << 20},
+        {"mib", 1ULL << 20},
+        {"mb", 1000ULL * 1000},
+        {"g", 1ULL << 30},
+        {"gib", 1ULL << 30},
+        {"gb", 1000ULL * 1000 * 1000},
+        {"t", 1ULL << 40},
+        {"tib", 1ULL << 40},
+        {"tb", 1000ULL * 1000 * 1000 * 1000},
+        {"", 1ULL},
+    }};
+
+    auto number = uint64_t(0);
+    auto const *end = s.data() + s.size();
+    auto [ptr, ec] = std::from_chars(s.data(), end, number);
+    if (ec != std::errc() || ptr == s.data()) {
+        return false;
+    }
+    auto suffix = std::string_view(ptr, end - ptr);
+    for (auto [name, factor] : units) {
+        if (equals_lower(suffix, name)) {
+            if (number > std::numeric_limits<uint64_t>::max() / factor) {
+                return false;
+            }
+            value.bytes = number * factor;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*********************************************************************************************************************
+ * argparse::tokenize implementation
+ *********************************************************************************************************************/
+
+auto argparse::tokenize(char const *const *argv, int argc) -> std::vector<token> {
+    auto tokens = std::vector<token>();
+    tokenize(argv, argc, tokens);
+    return tokens;
+}
+
+/*!
+ * Classifies the arguments into the given vector, shared by std::vector and std::pmr::vector
+ */
+template <typename Vector> static auto tokenize_into(char const *const *argv, int argc, Vector &tokens) -> void {
+    tokens.resize(std::max(argc, 0));
+    auto words = 0;
+    for (auto i = argc - 1; i >= 0; --i) {
+        std::string_view sv(argv[i]);
+        auto kind = argparse::token_kind::word;
+
+        if (sv.length() > 1 && sv.starts_with('-')) {
+            if (sv == "--") {
+                kind = argparse::token_kind::separator;
+            } else if (sv == "--help" || sv == "-h") {
+                kind = argparse::token_kind::help;
+            } else {
+                kind = argparse::token_kind::flag;
+            }
+        }
+        words = kind == argparse::token_kind::word ? words + 1 : 0;
+        tokens[i] = argparse::token{kind, sv, words};
+    }
+}
+
+auto argparse::tokenize(char const *const *argv, int argc, std::vector<token> &tokens) -> void {
+    tokenize_into(argv, argc, tokens);
+}
+
+auto argparse::tokenize(char const *const *argv, int argc, std::pmr::vector<token> &tokens) -> void {
+    tokenize_into(argv, argc, tokens);
+}
+
+/*********************************************************************************************************************
+ * argparse::help_text implementation
+ *********************************************************************************************************************/
+
+#ifdef ARGPARSE_POSIX
+namespace {
+
+// Buffer of std::cout unless redirected by the application
+auto *const stdout_buffer = std::cout.rdbuf();
+
+} // namespace
+#endif
+
+auto argparse::help_text::wrap(std::string_view text, size_t indent) -> help_text & {
+    constexpr size_t min_columns = 20;
+    auto avail = _columns > indent + min_columns ? _columns - indent : min_columns;
+    size_t used = 0;
+    auto pad_line = false;
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        if (text[pos] == ' ') {
+            ++pos;
+            continue;
+        }
+        if (text[pos] == '\n') {
+            put('\n');
+            used = 0;
+            pad_line = true;
+            ++pos;
+            continue;
+        }
+
+        auto end = std::min(text.find_first_of(" \n", pos), text.size());
+        auto len = end - pos;
+        if (used > 0 && used + 1 + len > avail) {
+            put('\n');
+            used = 0;
+            pad_line = true;
+        }
+        if (pad_line) {
+            // Indent only lines with content, empty lines stay free of trailing spaces
+            pad(indent);
+            pad_line = false;
+        }
+        if (used > 0) {
+            put(' ');
+            used += 1;
+        }
+        put(text.substr(pos, len));
+        used += len;
+        pos = end;
+    }
+    return *this;
+}
+
+auto argparse::terminal_columns() -> size_t {
+#if defined(ARGPARSE_POSIX) && defined(TIOCGWINSZ)
+    auto ws = winsize();
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0) {
+        return ws.ws_col;
+    }
+#endif
+    if (auto const *env = std::getenv("COLUMNS"); env != nullptr) {
+        auto columns = std::string_view(env);
+        auto cnt = size_t(0);
+        auto [ptr, ec] = std::from_chars(columns.data(), columns.data() + columns.size(), cnt);
+        if (ec == std::errc() && cnt > 0) {
+            return cnt;
+        }
+    }
+    return 80;
+}
 
-template <> auto argparse::parse(char const *const s) -> std::string { return s; }
+auto argparse::write_help(std::string_view text) -> void {
+#ifdef ARGPARSE_POSIX
+    // Terminals are line buffered, a single write(..) avoids one system call per line
+    if (std::cout.rdbuf() == stdout_buffer) {
+        std::cout.flush();
+        std::fflush(stdout);
+        while (!text.empty()) {
+            auto cnt = ::write(STDOUT_FILENO, text.data(), text.size());
+            if (cnt < 0 && errno == EINTR) {
+                continue;
+            }
+            if (cnt <= 0) {
+                // Nothing was written, retrying would spin forever
+                break;
+            }
+            text.remove_prefix(static_cast<size_t>(cnt));
+        }
+        return;
+    }
+#endif
+    std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+    std::cout.flush();
+}
 
 /*********************************************************************************************************************
  * argparse::optional::optional implementation
  *********************************************************************************************************************/
 
 argparse::optional::optional(char _short, std::string_view _long, std::string_view _desc)
-    : _short(_short), _long(_long), _desc(_desc) {}
+    : optional(_short, _long, _desc, arg_kind::custom) {}
+
+argparse::optional::optional(char _short, std::string_view _long, std::string_view _desc, arg_kind kind,
+                             void const *type)
+    : _short(_short), _long(_long), _desc(_desc), _touched(false), _kind(kind), _type(type), _id(0) {}
 
 argparse::optional::~optional() = default;
 
@@ -52,17 +376,33 @@ auto argparse::optional::parse(char const *const * /*argv*/, int /*argc*/) -> in
 
 auto argparse::optional::desc() -> std::string_view const & { return _desc; }
 
+auto argparse::optional::find_invalid(char const *const * /*argv*/, size_t /*len*/) const -> char const * {
+    return nullptr;
+}
+
+auto argparse::optional::invalid(std::string_view value) const -> void {
+    std::cerr << "Invalid value '" << value << "' for -" << _short << ", --" << _long << std::endl;
+}
+
+auto argparse::optional::overflow() const -> void {
+    std::cerr << "Too many values for -" << _short << ", --" << _long << std::endl;
+}
+
 argparse::optional_flag::optional_flag(char _short, std::string_view _long, std::string_view _desc)
-    : optional(_short, _long, _desc), _cnt(0), _flag(false) {}
+    : optional(_short, _long, _desc, arg_kind::flag, type_of<optional_flag>()), _cnt(0), _flag(false) {}
 
 auto argparse::optional_flag::takes() -> size_t { return 0; }
 
-auto argparse::optional_flag::parse(char const *const *argv, int len) -> int {
-    _flag = true;
-    _cnt += 1;
+auto argparse::optional_flag::parse(char const *const * /*argv*/, int /*len*/) -> int {
+    add();
     return 0;
 }
 
+auto argparse::optional_flag::reset() -> void {
+    _flag = false;
+    _cnt = 0;
+}
+
 auto argparse::optional_flag::is_set() const -> bool { return _flag; }
 
 auto argparse::optional_flag::cnt() const -> size_t { return _cnt; }
@@ -71,7 +411,12 @@ auto argparse::optional_flag::cnt() const -> size_t { return _cnt; }
  * argparse::argument implementation
  *********************************************************************************************************************/
 
-argparse::argument::argument(std::string_view _name, std::string_view _desc) : _name(_name), _desc(_desc) {}
+argparse::argument::argument(std::string_view _name, std::string_view _desc)
+    : argument(_name, _desc, arg_kind::custom) {}
+
+argparse::argument::argument(std::string_view _name, std::string_view _desc, arg_kind kind, void const *type)
+    : _name(_name), _desc(_desc), _touched(false), _kind(kind), _type(type), _id(0) {}
+
 argparse::argument::~argument() = default;
 
 auto argparse::argument::desc() -> std::string_view const & { return _desc; }
@@ -82,11 +427,93 @@ auto argparse::argument::parse(char const *const * /*argv*/, int /*len*/) -> int
     throw std::runtime_error("Called 'parse' on argument type.");
 }
 
+auto argparse::argument::find_invalid(char const *const * /*argv*/, size_t /*len*/) const -> char const * {
+    return nullptr;
+}
+
+auto argparse::argument::invalid(std::string_view value) const -> void {
+    std::cerr << "Invalid value '" << value << "' for " << _name << std::endl;
+}
+
+auto argparse::argument::overflow() const -> void { std::cerr << "Too many values for " << _name << std::endl; }
+
+auto argparse::argument::unreadable(stream_reader const &reader) const -> void {
+    if (reader.overflowed()) {
+        std::cerr << "Value exceeds " << stream_reader::buffer_size << " bytes for " << _name << std::endl;
+    } else {
+        std::cerr << "Unable to read values for " << _name << std::endl;
+    }
+}
+
+/*********************************************************************************************************************
+ * argparse::stream_reader implementation
+ *********************************************************************************************************************/
+
+argparse::stream_reader::stream_reader(int fd, char delim)
+    : _fd(fd), _delim(delim), _buffer(std::make_unique_for_overwrite<char[]>(buffer_size + 1)) {}
+
+auto argparse::stream_reader::next() -> char const * {
+    auto *buffer = _buffer.get();
+    while (!_failed) {
+        auto *next = static_cast<char *>(std::memchr(buffer + _begin, _delim, _end - _begin));
+        if (next != nullptr) {
+            // Empty values are skipped, e.g. of blank lines
+            *next = '\0';
+            auto *value = buffer + _begin;
+            _begin = static_cast<size_t>(next - buffer) + 1;
+            if (next > value) {
+                return value;
+            }
+            continue;
+        }
+        if (_eof) {
+            // Last value without delimiter
+            if (_begin == _end) {
+                return nullptr;
+            }
+            buffer[_end] = '\0';
+            auto *value = buffer + _begin;
+            _begin = _end;
+            return value;
+        }
+
+        std::memmove(buffer, buffer + _begin, _end - _begin);
+        _end -= _begin;
+        _begin = 0;
+        if (_end == buffer_size) {
+            _overflowed = true;
+            _failed = true;
+            break;
+        }
+#ifdef ARGPARSE_POSIX
+        // Partial reads deliver the values written to a pipe so far without waiting for a full buffer
+        auto cnt = ::read(_fd, buffer + _end, buffer_size - _end);
+        while (cnt < 0 && errno == EINTR) {
+            cnt = ::read(_fd, buffer + _end, buffer_size - _end);
+        }
+#else
+        // Without POSIX only stdin is supported
+        auto cnt = _fd == 0 ? static_cast<long>(std::fread(buffer + _end, 1, buffer_size - _end, stdin)) : -1L;
+        cnt = cnt == 0 && std::ferror(stdin) ? -1 : cnt;
+#endif
+        if (cnt < 0) {
+            _failed = true;
+            break;
+        }
+        _eof = cnt == 0;
+        _end += static_cast<size_t>(cnt);
+    }
+    return nullptr;
+}
+
 /*********************************************************************************************************************
  * argparse::command implementation
  *********************************************************************************************************************/
 
-argparse::command::command(std::string_view _name, std::string_view _desc) : argument(_name, _desc) {}
+argparse::command::command(std::string_view _name, std::string_view _desc, std::pmr::memory_resource *resource)
+    : argument(_name, _desc, arg_kind::command), _base(resource), _own_tree(resource), _tree(&_own_tree),
+      _optional(resource), _records(resource), _required(resource), _commands(resource), _long_index(resource),
+      _required_index(resource), _command_index(resource), _help(resource) {}
 
 auto argparse::command::add_command(std::string_view name, std::string_view desc) -> command & {
     if (name.find(' ') != std::string_view::npos) {
@@ -94,191 +521,689 @@ auto argparse::command::add_command(std::string_view name, std::string_view desc
         abort();
     }
 
-    auto arg = std::make_unique<command>(name, desc);
-    if (std::ranges::any_of(_commands.begin(), _commands.end(),
-                            [name](auto &ptr) -> bool { return name == ptr->name(); })) {
+    ARGPARSE_STATS_TIME(_tree->counters.build_ns);
+    ARGPARSE_STATS_ADD(_tree->counters.comparisons, 1);
+    ARGPARSE_STATS_ADD(_tree->counters.nodes, 1);
+    ARGPARSE_STATS_ADD(_tree->counters.bytes, sizeof(command));
+
+    if (_command_index.contains(name)) {
         auto msg = std::string("Duplicated command for ") + name.data();
         throw std::runtime_error(msg);
     }
+    auto arg = make_node<command>(_tree->resource, name, desc, _tree->resource);
 
-    auto s = std::string(_name.data()) + " ";
-    if (!_base.empty()) {
-
-        s = std::string(_base.data()) + " " + s;
-    }
-
-    arg->set_base(s);
+    arg->_base.reserve(_base.size() + _name.size() + 1);
+    arg->_base.append(_base).append(_name).append(" ");
+    arg->_tree = _tree;
+    arg->_id = _tree->commands++;
     auto cmd = arg.get();
     _commands.push_back(std::move(arg));
+    _command_index.emplace(cmd->name(), cmd);
+    _help_columns = 0;
     return *cmd;
 }
 
 auto argparse::command::takes() -> size_t { return std::numeric_limits<size_t>::max(); }
 
+auto argparse::command::reset() -> void {
+    for (auto &o : _optional) {
+        o->reset();
+        o->_touched = false;
+    }
+    for (auto &r : _required) {
+        r->reset();
+        r->_touched = false;
+    }
+    for (auto &c : _commands) {
+        c->reset();
+    }
+}
+
 void argparse::command::set_base(std::string_view base) { _base = base; }
 
+auto argparse::command::find_command(std::string_view name, argparse::stats &st) const -> command * {
+    ARGPARSE_STATS_TIME(st.lookup_ns);
+    ARGPARSE_STATS_ADD(st.comparisons, 1);
+    auto it = _command_index.find(name);
+    return it == _command_index.end() ? nullptr : it->second;
+}
+
+auto argparse::command::find_optional(std::string_view arg, argparse::stats &st) const -> option_record const * {
+    ARGPARSE_STATS_TIME(st.lookup_ns);
+    if (arg.length() == 1) {
+        auto pos = _short_index[static_cast<unsigned char>(arg[0])];
+        return pos == 0 ? nullptr : &_records[pos - 1];
+    }
+
+    ARGPARSE_STATS_ADD(st.comparisons, 1);
+    auto it = _long_index.find(arg);
+    return it == _long_index.end() ? nullptr : &_records[it->second];
+}
+
 auto argparse::command::parse(char const *const *argv, int argc) -> int {
-    auto next_idx = [argc, argv](int pos) -> int {
-        for (auto i = pos; i < argc; ++i) {
-            std::string_view sv(argv[i]);
-            if (sv.starts_with("-")) {
-                return i;
+    // The token buffer of the tree is reused, thus parsing again doesn't allocate
+    auto &state = _tree->state;
+    tokenize(argv, argc, state.tokens);
+    return parse(argv, state.tokens, state);
+}
+
+/*!
+ * Stores the values of parse runs without result in the nodes, which are remembered for reset()
+ */
+struct argparse::command::node_sink {
+    parse_state &state;
+    argparse::stats &st;
+
+    auto enter(command &) -> void {}
+
+    auto store(option_record const &rec, char const *const *argv, int len) -> int {
+        auto used = 0;
+        switch (rec.kind) {
+        case arg_kind::flag:
+            static_cast<optional_flag *>(rec.node)->add();
+            break;
+        default:
+            used = rec.node->parse(argv, len);
+        }
+        if (used != -1 && !rec.node->_touched) {
+            rec.node->_touched = true;
+            state.optionals.push_back(rec.node);
+        }
+        return used;
+    }
+
+    auto store(argument &arg, char const *const *argv, int len) -> int {
+        auto used = arg.parse(argv, len);
+        if (used != -1 && !arg._touched) {
+            arg._touched = true;
+            state.arguments.push_back(&arg);
+        }
+        return used;
+    }
+};
+
+/*!
+ * Stores the values in a result, the nodes are only read
+ */
+struct argparse::command::result_sink {
+    result &res;
+    argparse::stats &st;
+
+    auto enter(command const &cmd) -> void { res.set(cmd); }
+    auto store(option_record const &rec, char const *const *argv, int len) -> int { return res.store(rec, argv, len); }
+    auto store(argument &arg, char const *const *argv, int len) -> int { return res.store(arg, argv, len); }
+};
+
+auto argparse::command::parse(char const *const *argv, std::span<token const> tokens, parse_state &state) -> int {
+    auto sink = node_sink{state, _tree->counters};
+    return parse_tokens(*this, argv, tokens, sink);
+}
+
+auto argparse::command::parse(char const *const *argv, std::span<token const> tokens, result &res) const -> int {
+    auto sink = result_sink{res, res._stats};
+    return parse_tokens(*this, argv, tokens, sink);
+}
+
+template <typename Self, typename Sink>
+auto argparse::command::parse_tokens(Self &self, char const *const *argv, std::span<token const> tokens, Sink &sink)
+    -> int {
+    sink.enter(self);
+    auto &st = sink.st;
+
+    auto argc = static_cast<int>(tokens.size());
+    auto next_idx = [&self, tokens, argc, &st](int start) -> int {
+        if (start >= argc) {
+            return argc;
+        }
+        auto limit = start + tokens[start].words;
+        if (!self._commands.empty()) {
+            for (auto i = start; i < limit; ++i) {
+                if (self.find_command(tokens[i].value, st) != nullptr) {
+                    return i;
+                }
             }
         }
-        return argc;
+        return limit;
     };
 
     auto pos = 1;
+    auto end = 1;
     while (pos < argc) {
-        std::string_view sv(argv[pos]);
-        auto end = next_idx(pos + 1);
+        // Values of an option never span another option or command, thus only recompute once passed
+        if (end <= pos) {
+            end = next_idx(pos + 1);
+        }
+        auto const &tok = tokens[pos];
 
-        if (sv == "--help" || sv == "-h") {
-            show_help();
+        if (tok.kind == token_kind::help) {
+            ARGPARSE_STATS_TIME(st.help_ns);
+            self.show_help();
             return -1;
-        } else if (sv.starts_with('-') && sv != "--") {
-            auto handle = [&](std::string_view const arg) -> bool {
-                auto v =
-                    std::ranges::filter_view(std::span(_optional.begin(), _optional.end()), [arg](auto &ptr) -> bool {
-                        auto [s, l] = ptr->abbr();
-                        return arg.length() == 1 ? (s == arg[0]) : (l == arg);
-                    });
-
-                if (v.empty()) {
-                    return false;
+        } else if (tok.kind == token_kind::flag) {
+            auto handle = [&](std::string_view const arg) -> int {
+                auto opt = self.find_optional(arg, st);
+                if (opt == nullptr) {
+                    return -1;
                 }
 
-                auto used = (*v.begin())->parse(&argv[pos + 1], end - pos - 1);
+                auto used = 0;
+                {
+                    ARGPARSE_STATS_TIME(st.convert_ns);
+                    used = sink.store(*opt, &argv[pos + 1], end - pos - 1);
+                }
                 if (used == -1) {
-                    show_help();
-                    return false;
+                    ARGPARSE_STATS_TIME(st.help_ns);
+                    self.show_help();
                 }
-                pos += used + 1;
-                return true;
+                return used;
             };
 
-            if (sv.starts_with("--")) {
-                if (!handle(sv.substr(2))) {
+            // Flags combined like `-vvv` share the following values
+            auto used = 0;
+            if (tok.value.starts_with("--")) {
+                used = handle(tok.value.substr(2));
+                if (used == -1) {
                     return -1;
                 }
             } else {
-                for (auto i = 1; i < sv.length(); ++i) {
-                    if (!handle(sv.substr(i, 1))) {
+                for (size_t i = 1; i < tok.value.length(); ++i) {
+                    auto u = handle(tok.value.substr(i, 1));
+                    if (u == -1) {
                         return -1;
                     }
+                    used += u;
                 }
             }
-        } else if (pos != argc) {
-            auto c = _commands.begin();
-            while (c != _commands.end()) {
-                if ((*c)->name() == sv) {
-                    auto used = (*c)->parse(&argv[pos], argc - pos);
+            pos += used + 1;
+        } else {
+            command *c = nullptr;
+            if (tok.kind == token_kind::word) {
+                c = self.find_command(tok.value, st);
+                if (c != nullptr) {
+                    auto used = parse_tokens(static_cast<Self &>(*c), &argv[pos], tokens.subspan(pos), sink);
                     if (used == -1) {
                         return -1;
                     }
-                    pos += used + 1;
-                    break;
+                    pos += used;
                 }
-                ++c;
+            } else {
+                // Skip `--` used to force continuation with required arguments
+                pos += 1;
             }
-            if (c == _commands.end()) {
-                for (auto &r : _required) {
+
+            if (pos < argc && c == nullptr) {
+                for (auto &r : self._required) {
                     if (pos >= argc) {
-                        return -1;
+                        // Only the values of a stream may be omitted, they are read afterwards
+                        return r->_kind == arg_kind::stream ? pos : -1;
+                    }
+                    auto used = 0;
+                    {
+                        ARGPARSE_STATS_TIME(st.convert_ns);
+                        used = sink.store(*r, &argv[pos], argc - pos);
                     }
-                    auto used = r->parse(&argv[pos], argc - pos);
                     if (used == -1) {
                         return -1;
                     }
                     pos += used;
                 }
-                return pos >= argc;
+                return pos;
             }
         }
     }
 
-    return _required.empty() ? argc : -1;
+    // A stream is always the last argument and may be omitted
+    auto streamed = self._required.size() == 1 && self._required.front()->_kind == arg_kind::stream;
+    return self._required.empty() || streamed ? pos : -1;
+}
+
+namespace {
+
+// Guards the rendered help messages of all commands
+auto help_mutex = std::mutex();
+
+} // namespace
+
+auto argparse::command::help_columns() const -> size_t {
+    return _tree->columns > 0 ? _tree->columns : terminal_columns();
 }
 
 auto argparse::command::show_help() const -> void {
-    std::cout << std::endl << "    Usage: " << _base << _name << " ";
+    auto columns = help_columns();
+    auto lock = std::scoped_lock(help_mutex);
+    write_help(cached_help(columns));
+}
+
+/*!
+ * Returns the help message rendered for the line width, only valid while holding help_mutex
+ */
+auto argparse::command::cached_help(size_t columns) const -> std::string_view {
+    if (_help_columns != columns) {
+        // The terminal was resized or the command modified, the capacity of the string is reused
+        _help.clear();
+        auto out = help_text(_help);
+        render_help(out, columns);
+        _help_columns = columns;
+    }
+    return _help;
+}
+
+auto argparse::command::render_help(std::span<char> buffer) const -> size_t {
+    auto columns = help_columns();
+    auto lock = std::scoped_lock(help_mutex);
+    auto help = cached_help(columns);
+    std::copy_n(help.data(), std::min(help.size(), buffer.size()), buffer.data());
+    return help.size();
+}
+
+auto argparse::command::render_help(std::string &out) const -> void {
+    auto columns = help_columns();
+    auto lock = std::scoped_lock(help_mutex);
+    out.append(cached_help(columns));
+}
+
+auto argparse::command::drop_help() -> void {
+    _help_columns = 0;
+    for (auto &c : _commands) {
+        c->drop_help();
+    }
+}
+
+auto argparse::command::render_help(help_text &out, size_t columns) const -> void {
+    out.columns(columns);
+    out.put("\n    Usage: ").put(_base).put(_name).put(' ');
 
     if (!_optional.empty()) {
-        std::cout << "[OPTIONS] ";
+        out.put("[OPTIONS] ");
     }
     if (!_commands.empty()) {
-        std::cout << "[COMMAND] ";
+        out.put("[COMMAND] ");
     }
 
     for (auto &r : _required) {
-
-        std::cout << r->name() << " ";
-        if (r->takes() > 1) {
-            std::cout << "[" << r->name() << "...] ";
+        if (r->_kind == arg_kind::stream) {
+            // Values of a stream are optional on the commandline
+            out.put('[').put(r->name()).put("...] ");
+            continue;
+        }
+        out.put(r->name()).put(' ');
+        if (r->limit() > 1) {
+            out.put('[').put(r->name()).put("...] ");
         }
     }
-    std::cout << std::endl << std::endl;
+    out.put("\n\n");
 
     if (!_desc.empty()) {
-        size_t start = 0;
-        size_t end = 0;
-        while (start < _desc.size()) {
-            auto pos = _desc.find(' ', end + 1);
-            if (pos == std::string_view::npos) {
-                std::cout << "    " << _desc.substr(start) << std::endl;
-                break;
-            } else {
-                if ((pos - start) > 80) {
-                    std::cout << "    " << _desc.substr(start, end - start) << std::endl;
-
-                    start = end + 1;
-
-                    end = end + 1;
-                } else {
-                    end = pos;
-                }
-            }
-        }
-        std::cout << std::endl;
+        out.put("    ").wrap(_desc, 4).put("\n\n");
     }
 
     if (!_optional.empty()) {
         size_t width = 4;
-        std::ranges::for_each(_optional.begin(), _optional.end(), [&width](auto &v) {
-            auto [s, l] = v->abbr();
-            width = std::max<size_t>(width, l.length() + 4);
-        });
+        for (auto &o : _optional) {
+            width = std::max<size_t>(width, o->_long.length() + 4);
+        }
 
-        std::cout << "    Options:" << std::endl << std::endl;
+        out.put("    Options:\n\n");
         for (auto &o : _optional) {
-            auto [s, l] = o->abbr();
-            std::cout << "        -" << s << ", --" << std::left << std::setw(width) << l << o->desc() << std::endl;
+            out.put("        -").put(o->_short).put(", --").put(o->_long);
+            out.pad(width - o->_long.length()).wrap(o->_desc, 14 + width).put('\n');
         }
-        std::cout << std::endl;
+        out.put('\n');
     }
 
     if (!_commands.empty()) {
         size_t width = 4;
-        std::ranges::for_each(_commands.begin(), _commands.end(),
-                              [&width](auto &v) { width = std::max<size_t>(width, v->name().length() + 4); });
+        for (auto &c : _commands) {
+            width = std::max<size_t>(width, c->_name.length() + 4);
+        }
 
-        std::cout << "    Commands:" << std::endl << std::endl;
-        for (auto &r : _commands) {
-            std::cout << "        " << std::left << std::setw(width) << r->name() << r->desc() << std::endl;
+        out.put("    Commands:\n\n");
+        for (auto &c : _commands) {
+            out.put("        ").put(c->_name).pad(width - c->_name.length()).wrap(c->_desc, 8 + width).put('\n');
         }
-        std::cout << std::endl << "        See '<command> --help' for additional info." << std::endl << std::endl;
+        out.put("\n        See '<command> --help' for additional info.\n\n");
     }
 
     if (!_required.empty()) {
-
         size_t width = 4;
-        std::ranges::for_each(_required.begin(), _required.end(),
-                              [&width](auto &v) { width = std::max<size_t>(width, v->name().length() + 4); });
-        std::cout << "    Required:" << std::endl << std::endl;
         for (auto &r : _required) {
-            std::cout << "        " << std::left << std::setw(width) << r->name() << r->desc() << std::endl;
+            width = std::max<size_t>(width, r->_name.length() + 4);
+        }
+
+        out.put("    Required:\n\n");
+        for (auto &r : _required) {
+            out.put("        ").put(r->_name).pad(width - r->_name.length()).wrap(r->_desc, 8 + width).put('\n');
+        }
+        out.put('\n');
+    }
+}
+
+/*********************************************************************************************************************
+ * argparse::result implementation
+ *********************************************************************************************************************/
+
+auto argparse::result::cnt(optional_flag const &flag) const -> size_t {
+    auto e = find(_optionals, flag._id);
+    return e == nullptr ? 0 : e->cnt;
+}
+
+auto argparse::result::is_set(optional_flag const &flag) const -> bool { return cnt(flag) > 0; }
+
+auto argparse::result::get_stats() const -> argparse::stats const & { return _stats; }
+
+auto argparse::result::is_set(command const &cmd) const -> bool {
+    return cmd._id < _commands.size() && _commands[cmd._id] != 0;
+}
+
+auto argparse::result::prepare(size_t optionals, size_t arguments, size_t commands) -> void {
+    // Only the entries of the previous run are cleared, the capacity of all buffers is kept
+    for (auto id : _touched_optionals) {
+        _optionals[id].cnt = 0;
+        _optionals[id].values.clear();
+    }
+    for (auto id : _touched_arguments) {
+        _arguments[id].cnt = 0;
+        _arguments[id].values.clear();
+    }
+    for (auto id : _touched_commands) {
+        _commands[id] = 0;
+    }
+    _touched_optionals.clear();
+    _touched_arguments.clear();
+    _touched_commands.clear();
+
+    _optionals.resize(optionals);
+    _arguments.resize(arguments);
+    _commands.resize(commands);
+}
+
+auto argparse::result::store(entry &e, std::vector<size_t> &touched, size_t id, size_t takes,
+                             char const *const *argv, int len) -> int {
+    auto untouched = e.cnt == 0;
+    auto used = 0;
+    if (takes == 0) {
+        e.cnt += 1;
+    } else {
+        if (len < 1) {
+            return -1;
+        }
+        // A single value is replaced, lists are extended
+        if (takes == 1) {
+            e.values.clear();
+        }
+        used = static_cast<int>(std::min<size_t>(takes, len));
+        e.values.insert(e.values.end(), argv, argv + used);
+        e.cnt = e.values.size();
+    }
+    if (untouched) {
+        touched.push_back(id);
+    }
+    return used;
+}
+
+auto argparse::result::store(option_record const &rec, char const *const *argv, int len) -> int {
+    auto takes = size_t(0);
+    switch (rec.kind) {
+    case arg_kind::flag:
+        // Takes no values, thus there is nothing to validate
+        return store(_optionals[rec.id], _touched_optionals, rec.id, 0, argv, len);
+    case arg_kind::value:
+        takes = 1;
+        break;
+    case arg_kind::list:
+        takes = std::numeric_limits<size_t>::max();
+        break;
+    default:
+        takes = rec.node->takes();
+    }
+    if (auto const *value = rec.node->find_invalid(argv, std::max(len, 0)); value != nullptr) {
+        rec.node->invalid(value);
+        return -1;
+    }
+    return store(_optionals[rec.id], _touched_optionals, rec.id, takes, argv, len);
+}
+
+auto argparse::result::store(argument &arg, char const *const *argv, int len) -> int {
+    if (auto const *value = arg.find_invalid(argv, std::max(len, 0)); value != nullptr) {
+        arg.invalid(value);
+        return -1;
+    }
+    return store(_arguments[arg._id], _touched_arguments, arg._id, arg.limit(), argv, len);
+}
+
+auto argparse::result::set(command const &cmd) -> void {
+    if (_commands[cmd._id] == 0) {
+        _commands[cmd._id] = 1;
+        _touched_commands.push_back(cmd._id);
+    }
+}
+
+/*********************************************************************************************************************
+ * argparse::response_args implementation
+ *********************************************************************************************************************/
+
+namespace {
+
+constexpr int response_max_depth = 16;
+constexpr size_t response_read_size = 65536;
+
+enum class response_class : unsigned char { plain = 0, space, special };
+
+// Class of each byte, plain bytes are skipped without inspecting quotes
+constexpr auto response_classes = [] {
+    auto classes = std::array<response_class, 256>();
+    for (unsigned char c : std::string_view(" \t\n\r\v\f")) {
+        classes[c] = response_class::space;
+    }
+    for (unsigned char c : std::string_view("\"'\\")) {
+        classes[c] = response_class::special;
+    }
+    return classes;
+}();
+
+auto response_class_of(char c) -> response_class { return response_classes[static_cast<unsigned char>(c)]; }
+
+// Same messages as reported by the C library
+auto response_error(std::string_view prefix, char const *path, std::string_view suffix = ".") -> std::runtime_error {
+    return std::runtime_error(std::string(prefix) + " '" + path + "'" + std::string(suffix));
+}
+
+} // namespace
+
+argparse::response_args::response_args(int argc, char *argv[], size_t limit) : _limit(limit) {
+    try {
+        for (int i = 0; i < argc; ++i) {
+            // Name of the application is never expanded
+            if (i == 0) {
+                _argv.push_back(argv[i]);
+            } else {
+                add(argv[i], 1);
+            }
+        }
+        _argv.push_back(nullptr);
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+argparse::response_args::~response_args() { release(); }
+
+auto argparse::response_args::release() -> void {
+#ifdef ARGPARSE_POSIX
+    for (auto &r : _regions) {
+        if (r.mapped) {
+            munmap(r.data, r.len);
+        }
+    }
+#endif
+    _regions.clear();
+}
+
+auto argparse::response_args::reserve(char const *path, size_t size) -> void {
+    if (_limit > 0 && (size > _limit || _size > _limit - size)) {
+        throw response_error("Response file", path, " exceeds the size limit.");
+    }
+    _size += size;
+}
+
+auto argparse::response_args::add(char *arg, int depth) -> void {
+    if (arg[0] != '@' || arg[1] == '\0') {
+        _argv.push_back(arg);
+    } else {
+        expand(&arg[1], depth);
+    }
+}
+
+auto argparse::response_args::expand(char const *path, int depth) -> void {
+    if (depth > response_max_depth) {
+        throw response_error("Response file", path, " is nested too deeply.");
+    }
+    auto &r = open(path);
+    tokenize(path, r.data, r.len - 1, depth);
+}
+
+/*!
+ * Reads the whole stream into the heap, used for pipes and if mapping is not supported. The stream is closed in any
+ * case, also if the size limit is exceeded.
+ */
+auto argparse::response_args::read(char const *path, std::FILE *stream) -> region & {
+    auto heap = std::vector<char>();
+    auto len = size_t(0);
+    try {
+        while (true) {
+            heap.resize(len + response_read_size + 1);
+            auto cnt = std::fread(heap.data() + len, 1, response_read_size, stream);
+            reserve(path, cnt);
+            len += cnt;
+            if (cnt < response_read_size) {
+                break;
+            }
+        }
+    } catch (...) {
+        std::fclose(stream);
+        throw;
+    }
+    auto failed = std::ferror(stream) != 0;
+    std::fclose(stream);
+    if (failed) {
+        throw response_error("Unable to read response file", path);
+    }
+    heap[len] = '\0';
+    auto &r = _regions.emplace_back(region{nullptr, len + 1, false, std::move(heap)});
+    r.data = r.heap.data();
+    return r;
+}
+
+/*!
+ * Loads the response file into a private writable region followed by one zero byte, thus tokens are terminated in
+ * place. Regular files are mapped, all pages are faulted in at once since tokenizing writes to nearly every page.
+ */
+auto argparse::response_args::open(char const *path) -> region & {
+#ifdef ARGPARSE_POSIX
+    auto fd = ::open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        throw response_error("Unable to open response file", path);
+    }
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        auto size = static_cast<size_t>(st.st_size);
+        try {
+            reserve(path, size);
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+#ifdef MAP_POPULATE
+        constexpr int populate = MAP_POPULATE;
+#else
+        constexpr int populate = 0;
+#endif
+        // Reserve one byte more than the file, the mapping of the file ends at a page boundary
+        auto *data = mmap(nullptr, size + 1, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data != MAP_FAILED &&
+            mmap(data, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED | populate, fd, 0) == MAP_FAILED) {
+            munmap(data, size + 1);
+            data = MAP_FAILED;
+        }
+        close(fd);
+        if (data == MAP_FAILED) {
+            throw response_error("Unable to map response file", path);
+        }
+        return _regions.emplace_back(region{static_cast<char *>(data), size + 1, true, {}});
+    }
+    auto *stream = fdopen(fd, "rb");
+    if (stream == nullptr) {
+        close(fd);
+        throw response_error("Unable to open response file", path);
+    }
+#else
+    auto *stream = std::fopen(path, "rb");
+    if (stream == nullptr) {
+        throw response_error("Unable to open response file", path);
+    }
+#endif
+    return read(path, stream);
+}
+
+/*!
+ * Splits the content into whitespace separated tokens. Single quotes take everything literally, inside of double
+ * quotes a backslash only escapes '"' and '\', outside of quotes it escapes any character. Removing quotes and
+ * escapes only shrinks a token, thus each is written back to its own position and terminated by a zero byte.
+ */
+auto argparse::response_args::tokenize(char const *path, char *data, size_t len, int depth) -> void {
+    auto *end = data + len;
+    auto *pos = data;
+    while (pos < end) {
+        if (response_class_of(*pos) == response_class::space) {
+            ++pos;
+            continue;
+        }
+
+        // Only a leading '@' outside of quotes names a response file, thus "@name", '@name' and \@name are literal
+        // arguments. Quotes following the '@' belong to the name, e.g. @"a b" names the file 'a b'.
+        auto nested = *pos == '@';
+        auto *token = pos;
+        while (pos < end && response_class_of(*pos) == response_class::plain) {
+            ++pos;
+        }
+
+        // Quotes and escapes are removed by copying the remainder of the token
+        auto *out = pos;
+        auto quote = '\0';
+        while (pos < end && (quote != '\0' || response_class_of(*pos) != response_class::space)) {
+            auto c = *pos++;
+            if (quote == '\'') {
+                if (c == '\'') {
+                    quote = '\0';
+                } else {
+                    *out++ = c;
+                }
+            } else if (c == '\\' && pos < end && (quote == '\0' || *pos == '"' || *pos == '\\')) {
+                *out++ = *pos++;
+            } else if (c == '"' && quote == '"') {
+                quote = '\0';
+            } else if ((c == '"' || c == '\'') && quote == '\0') {
+                quote = c;
+            } else {
+                *out++ = c;
+            }
+        }
+        if (quote != '\0') {
+            throw response_error("Unterminated quote in response file", path);
+        }
+
+        // Both positions are equal if nothing was removed, the separator is consumed before it is overwritten
+        pos += pos < end ? 1 : 0;
+        *out = '\0';
+        if (nested && token[1] != '\0') {
+            expand(&token[1], depth + 1);
+        } else {
+            _argv.push_back(token);
         }
-        std::cout << std::endl;
     }
 }
 
@@ -286,9 +1211,59 @@ auto argparse::command::show_help() const -> void {
  * argparse::parser implementation
  *********************************************************************************************************************/
 
-argparse::parser::parser(std::string_view _name, std::string_view _desc) : command(_name, _desc) {}
+argparse::parser::parser(std::string_view _name, std::string_view _desc, std::pmr::memory_resource *resource)
+    : command(_name, _desc, resource) {}
 argparse::parser::~parser() = default;
 
-auto argparse::parser::parse(int argc, char *argv[]) -> bool { return command::parse(argv, argc) == -1 ? false : true; }
+/*!
+ * Classifies the arguments into the reused token buffer
+ */
+template <typename Vector>
+static auto classify(char const *const *argv, int argc, Vector &tokens, argparse::stats &st) -> void {
+    ARGPARSE_STATS_TIME(st.classify_ns);
+    ARGPARSE_STATS_ADD(st.tokens, std::max(argc, 0));
+#ifdef ARGPARSE_STATS
+    auto capacity = tokens.capacity();
+    argparse::tokenize(argv, argc, tokens);
+    st.bytes += (tokens.capacity() - capacity) * sizeof(argparse::token);
+#else
+    argparse::tokenize(argv, argc, tokens);
+#endif
+}
+
+auto argparse::parser::parse(int argc, char *argv[]) -> bool {
+    ARGPARSE_STATS_TIME(_tree->counters.parse_ns);
+    auto &state = _tree->state;
+    classify(argv, argc, state.tokens, _tree->counters);
+    return command::parse(argv, state.tokens, state) == argc;
+}
+
+auto argparse::parser::parse(int argc, char *argv[], result &res) const -> bool {
+    ARGPARSE_STATS_TIME(res._stats.parse_ns);
+    res.prepare(_tree->optionals, _tree->arguments, _tree->commands);
+    classify(argv, argc, res._tokens, res._stats);
+    return command::parse(argv, res._tokens, res) == argc;
+}
+
+auto argparse::parser::get_stats() const -> argparse::stats const & { return _tree->counters; }
+
+auto argparse::parser::set_columns(size_t columns) -> void {
+    _tree->columns = columns;
+    drop_help();
+}
+
+auto argparse::parser::reset() -> void {
+    auto &state = _tree->state;
+    for (auto o : state.optionals) {
+        o->reset();
+        o->_touched = false;
+    }
+    for (auto r : state.arguments) {
+        r->reset();
+        r->_touched = false;
+    }
+    state.optionals.clear();
+    state.arguments.clear();
+}
 
 /*********************************************************************************************************************/
@@ -26,12 +26,22 @@
 #define __ARGPARSE_CXX__
 
 #include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
 #include <limits>
 #include <memory>
+#include <memory_resource>
+#include <optional>
 #include <ranges>
 #include <span>
 #include <stdexcept>
+#include <string>
 #include <string_view>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
@@ -39,21 +49,466 @@ namespace argparse {
 
 /*********************************************************************************************************************
  *
- * argparse::parse template/specialization
+ * argparse::converter - conversion of values into the requested type
  *
- * This template and its specializations are used to parse the input
- * arguments into the requested type. Currently only int and std::string
- * are already implemented.
+ * The values are converted with std::from_chars, thus independent of the
+ * locale and without any allocation. Supported are all integer types
+ * (decimal or hex with `0x` prefix), float, double, bool, std::string,
+ * std::string_view (referencing argv, which outlives the parser),
+ * std::chrono durations like `250ms` and byte sizes like `64MiB`.
  *
- * FIXME: Make it possible to pass a custom converter into any of the
- *        added arguments.
+ * Further types are supported by specializing argparse::converter with a
+ * static `convert(std::string_view, T &) -> bool`. A value that can't be
+ * converted is reported and fails the parse run.
  *
  *********************************************************************************************************************/
 
-template <typename T> static auto parse(char const *const s) -> T;
+template <typename T> struct converter;
+
+// Parses 1 to 19 decimal digits, uses a SSE4.1 kernel if supported by the CPU and a scalar loop otherwise
+auto parse_digits(std::string_view s, uint64_t &value) -> bool;
+
+template <typename T>
+    requires(std::integral<T> && !std::same_as<T, bool>)
+struct converter<T> {
+    static auto convert(std::string_view s, T &value) -> bool {
+        // Fast path for plain decimal numbers, everything else is left to std::from_chars
+        auto negative = !s.empty() && s[0] == '-';
+        auto magnitude = uint64_t(0);
+        if (s.size() - negative <= 19 && parse_digits(s.substr(negative), magnitude)) {
+            if constexpr (std::is_signed_v<T>) {
+                using U = std::make_unsigned_t<T>;
+                if (magnitude > static_cast<uint64_t>(std::numeric_limits<T>::max()) + negative) {
+                    return false;
+                }
+                value = static_cast<T>(negative ? U(0) - static_cast<U>(magnitude) : static_cast<U>(magnitude));
+            } else {
+                if (negative || magnitude > std::numeric_limits<T>::max()) {
+                    return false;
+                }
+                value = static_cast<T>(magnitude);
+            }
+            return true;
+        }
+
+        auto base = 10;
+        if (s.size() > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+            s.remove_prefix(2);
+            base = 16;
+        }
+        auto const *end = s.data() + s.size();
+        auto [ptr, ec] = std::from_chars(s.data(), end, value, base);
+        return ec == std::errc() && ptr == end;
+    }
+};
+
+template <std::floating_point T> struct converter<T> {
+    static auto convert(std::string_view s, T &value) -> bool {
+        auto const *end = s.data() + s.size();
+        auto [ptr, ec] = std::from_chars(s.data(), end, value);
+        return ec == std::errc() && ptr == end;
+    }
+};
+
+// Accepts true/false, yes/no, on/off and 1/0
+template <> struct converter<bool> {
+    static auto convert(std::string_view s, bool &value) -> bool;
+};
+
+template <> struct converter<std::string> {
+    static auto convert(std::string_view s, std::string &value) -> bool {
+        value.assign(s);
+        return true;
+    }
+};
+
+template <> struct converter<std::string_view> {
+    static auto convert(std::string_view s, std::string_view &value) -> bool {
+        value = s;
+        return true;
+    }
+};
+
+// Parses a duration with one of the suffixes ns, us, ms, s, min and h. A value without suffix is given in `unit`.
+auto parse_duration(std::string_view s, long double unit, std::chrono::duration<long double, std::nano> &value)
+    -> bool;
+
+template <typename Rep, typename Period> struct converter<std::chrono::duration<Rep, Period>> {
+    using duration = std::chrono::duration<Rep, Period>;
+    using nanoseconds = std::chrono::duration<long double, std::nano>;
+
+    static auto convert(std::string_view s, duration &value) -> bool {
+        auto ns = nanoseconds();
+        if (!parse_duration(s, std::chrono::duration_cast<nanoseconds>(duration(1)).count(), ns)) {
+            return false;
+        }
+        if (ns > std::chrono::duration_cast<nanoseconds>(duration::max()) ||
+            ns < std::chrono::duration_cast<nanoseconds>(duration::min())) {
+            return false;
+        }
+        value = std::chrono::duration_cast<duration>(ns);
+        return true;
+    }
+};
+
+/*********************************************************************************************************************
+ *
+ * argparse::byte_size - size in bytes
+ *
+ * Accepts a plain number of bytes or a number with one of the suffixes
+ * B, K/KiB, M/MiB, G/GiB, T/TiB (powers of 1024) or KB, MB, GB, TB
+ * (powers of 1000), e.g. `64MiB` or `512K`.
+ *
+ *********************************************************************************************************************/
+
+struct byte_size {
+    uint64_t bytes = 0;
+};
+
+template <> struct converter<byte_size> {
+    static auto convert(std::string_view s, byte_size &value) -> bool;
+};
+
+template <typename T> auto convert(std::string_view s, T &value) -> bool { return converter<T>::convert(s, value); }
+
+// Converts the value or throws std::invalid_argument
+template <typename T> auto parse(char const *const s) -> T {
+    auto value = T();
+    if (!converter<T>::convert(s, value)) {
+        throw std::invalid_argument(std::string("Invalid value '") + s + "'");
+    }
+    return value;
+}
+
+// Converts the values into `out`, stops at the first invalid one and returns its index
+template <typename T> auto convert_values(T *out, char const *const *argv, int len) -> int {
+    for (auto i = 0; i < len; ++i) {
+        if (!converter<T>::convert(argv[i], out[i])) {
+            return i;
+        }
+    }
+    return len;
+}
+
+// Returns the first value that can't be converted into the type or nullptr
+template <typename T> auto find_invalid(char const *const *argv, size_t len) -> char const * {
+    if constexpr (!std::same_as<T, std::string> && !std::same_as<T, std::string_view>) {
+        auto value = T();
+        for (size_t i = 0; i < len; ++i) {
+            if (!converter<T>::convert(argv[i], value)) {
+                return argv[i];
+            }
+        }
+    }
+    return nullptr;
+}
+
+/*********************************************************************************************************************
+ *
+ * argparse::list_storage - storage of the values of a list
+ *
+ * The values are stored in a std::pmr::vector, by default allocated with
+ * new/delete or from the given memory resource. Alternatively the values
+ * are converted directly into a caller provided span. Its capacity limits
+ * the number of values, further values fail the parse run. In any case
+ * the storage is sized once per given list of values.
+ *
+ *********************************************************************************************************************/
 
-template <> auto parse(char const *const s) -> int;
-template <> auto parse(char const *const s) -> std::string;
+template <typename T> class list_storage {
+  public:
+    list_storage() = default;
+    explicit list_storage(std::pmr::memory_resource *resource) : _values(resource) {}
+    explicit list_storage(std::span<T> storage) : _storage(storage), _external(true) {}
+
+    auto values() const -> std::span<T const> {
+        return _external ? std::span<T const>(_storage.first(_size)) : std::span<T const>(_values);
+    }
+
+    // Number of values that can still be stored
+    auto available() const -> size_t {
+        return _external ? _storage.size() - _size : std::numeric_limits<size_t>::max();
+    }
+
+    // Appends the converted values, returns the index of the first invalid one. The list is unchanged on failure.
+    auto append(char const *const *argv, int len) -> int {
+        if (_external) {
+            auto cnt = convert_values(_storage.data() + _size, argv, len);
+            _size += cnt == len ? len : 0;
+            return cnt;
+        }
+        auto size = _values.size();
+        _values.resize(size + len);
+        auto cnt = convert_values(_values.data() + size, argv, len);
+        if (cnt < len) {
+            _values.resize(size);
+        }
+        return cnt;
+    }
+
+    auto clear() -> void {
+        _values.clear();
+        _size = 0;
+    }
+
+  private:
+    std::pmr::vector<T> _values;
+    std::span<T> _storage;
+    size_t _size = 0;
+    bool _external = false;
+};
+
+/*********************************************************************************************************************
+ *
+ * argparse::help_text - output of help messages
+ *
+ * Help messages are rendered into a single buffer, either appended to a
+ * string, e.g. the cached message of a command, or written into a caller
+ * provided buffer. Text exceeding the latter is only counted. The message
+ * is then written at once instead of line by line.
+ *
+ *********************************************************************************************************************/
+
+class help_text {
+  public:
+    explicit help_text(std::pmr::string &str) : _str(&str) {}
+    explicit help_text(std::span<char> buffer) : _buffer(buffer) {}
+
+    auto put(std::string_view s) -> help_text & {
+        _size += s.size();
+        if (_str != nullptr) {
+            _str->append(s);
+        } else {
+            auto cnt = std::min(s.size(), _buffer.size() - _used);
+            std::copy_n(s.data(), cnt, _buffer.data() + _used);
+            _used += cnt;
+        }
+        return *this;
+    }
+
+    auto put(char c) -> help_text & { return put(std::string_view(&c, 1)); }
+
+    auto pad(size_t n) -> help_text & {
+        constexpr auto spaces = std::string_view("                                ");
+        for (; n > spaces.size(); n -= spaces.size()) {
+            put(spaces);
+        }
+        return put(spaces.substr(0, n));
+    }
+
+    // Appends the words wrapped to the line width, the current line is at column `indent` and all following lines
+    // are indented by it. Manual linebreaks are kept, words exceeding a whole line are never split.
+    auto wrap(std::string_view text, size_t indent) -> help_text &;
+
+    // Line width of wrapped text
+    auto columns(size_t columns) -> help_text & {
+        _columns = columns;
+        return *this;
+    }
+
+    // Length of the complete text, including the text exceeding the buffer
+    auto size() const -> size_t { return _size; }
+
+  private:
+    std::pmr::string *_str = nullptr;
+    std::span<char> _buffer;
+    size_t _used = 0;
+    size_t _size = 0;
+    size_t _columns = 80;
+};
+
+// Writes the help message to std::cout by a single call
+auto write_help(std::string_view text) -> void;
+
+// Width of the terminal connected to stdout, otherwise given by the COLUMNS environment variable or 80
+auto terminal_columns() -> size_t;
+
+/*********************************************************************************************************************
+ *
+ * argparse::token - classification of a single commandline argument
+ *
+ * The arguments are classified once per parse. Each token additionally
+ * stores the number of consecutive plain words starting at its position,
+ * thus the end of a value list is known without rescanning the arguments.
+ * The count is relative, so subcommands operate on the tail of the same
+ * token array.
+ *
+ *********************************************************************************************************************/
+
+enum class token_kind { word, flag, separator, help };
+
+struct token {
+    token_kind kind;
+    std::string_view value;
+    int words;
+};
+
+auto tokenize(char const *const *argv, int argc) -> std::vector<token>;
+auto tokenize(char const *const *argv, int argc, std::vector<token> &tokens) -> void;
+auto tokenize(char const *const *argv, int argc, std::pmr::vector<token> &tokens) -> void;
+
+class optional;
+class argument;
+class command;
+class result;
+
+/*********************************************************************************************************************
+ *
+ * argparse::stats - timings and counters of a parser or result
+ *
+ * The values are only gathered if built with ARGPARSE_STATS. Otherwise
+ * they stay zero and no instrumentation is compiled in. Timings are in
+ * nanoseconds and accumulate over all calls.
+ *
+ *********************************************************************************************************************/
+
+struct stats {
+    uint64_t build_ns = 0;    // Adding options, arguments and commands including duplicate checks
+    uint64_t classify_ns = 0; // Classification of the commandline arguments
+    uint64_t lookup_ns = 0;   // Lookup of options and subcommands
+    uint64_t convert_ns = 0;  // Conversion and storing of values
+    uint64_t help_ns = 0;     // Output of help messages
+    uint64_t parse_ns = 0;    // Complete parse runs
+    size_t tokens = 0;        // Classified commandline arguments
+    size_t comparisons = 0;   // Comparisons of names
+    size_t nodes = 0;         // Options, arguments and commands created
+    size_t bytes = 0;         // Bytes allocated for nodes and token buffers
+};
+
+#ifdef ARGPARSE_STATS
+class stats_timer {
+  public:
+    explicit stats_timer(uint64_t &ns) : _ns(ns), _start(std::chrono::steady_clock::now()) {}
+    ~stats_timer() {
+        auto elapsed = std::chrono::steady_clock::now() - _start;
+        _ns += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+
+    stats_timer(stats_timer const &) = delete;
+    auto operator=(stats_timer const &) -> stats_timer & = delete;
+
+  private:
+    uint64_t &_ns;
+    std::chrono::steady_clock::time_point _start;
+};
+
+#define ARGPARSE_CONCAT_(a, b) a##b
+#define ARGPARSE_CONCAT(a, b) ARGPARSE_CONCAT_(a, b)
+#define ARGPARSE_STATS_TIME(ns) ::argparse::stats_timer ARGPARSE_CONCAT(_stats_timer_, __LINE__)(ns)
+#define ARGPARSE_STATS_ADD(value, n) ((value) += (n))
+#else
+// The counter is still consumed to keep stats parameters used
+#define ARGPARSE_STATS_TIME(ns) ((void)(ns))
+#define ARGPARSE_STATS_ADD(value, n) ((void)(value))
+#endif
+
+/*********************************************************************************************************************
+ *
+ * argparse::parse_state - state of parse runs
+ *
+ * The state is owned by the root of a tree and reused by all runs without
+ * result. It keeps the token buffer and the arguments that received values,
+ * thus a reset only visits those and parsing again doesn't allocate.
+ *
+ *********************************************************************************************************************/
+
+struct parse_state {
+    explicit parse_state(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : tokens(resource), optionals(resource), arguments(resource) {}
+
+    std::pmr::vector<token> tokens;
+    std::pmr::vector<optional *> optionals;
+    std::pmr::vector<argument *> arguments;
+};
+
+/*********************************************************************************************************************
+ *
+ * argparse::node_ptr - owning pointer to a node of the tree
+ *
+ * Options, arguments and commands are allocated from the memory resource
+ * of the parser. The deleter remembers size and alignment of the created
+ * type, thus nodes are released correctly through a base class pointer.
+ *
+ *********************************************************************************************************************/
+
+struct node_deleter {
+    std::pmr::memory_resource *resource;
+    size_t size;
+    size_t align;
+
+    template <typename T> auto operator()(T *node) const -> void {
+        node->~T();
+        resource->deallocate(node, size, align);
+    }
+};
+
+template <typename T> using node_ptr = std::unique_ptr<T, node_deleter>;
+
+template <typename T, typename... Args>
+auto make_node(std::pmr::memory_resource *resource, Args &&...args) -> node_ptr<T> {
+    auto *mem = resource->allocate(sizeof(T), alignof(T));
+    try {
+        return node_ptr<T>(new (mem) T(std::forward<Args>(args)...), node_deleter{resource, sizeof(T), alignof(T)});
+    } catch (...) {
+        resource->deallocate(mem, sizeof(T), alignof(T));
+        throw;
+    }
+}
+
+/*********************************************************************************************************************
+ *
+ * argparse::arg_kind - closed set of argument kinds
+ *
+ * Each option and argument stores its kind. The parse loop dispatches on
+ * it, thus flags and the number of values taken need no virtual call.
+ * Only the conversion of values stays with the typed classes. Classes
+ * derived by users are of kind custom and use the virtual interface.
+ *
+ *********************************************************************************************************************/
+
+enum class arg_kind : uint8_t { flag, value, list, command, stream, custom };
+
+// Unique address per type, identifies the concrete class of an option or argument without RTTI
+template <typename T> struct type_tag {
+    static constexpr char id = 0;
+};
+
+template <typename T> constexpr auto type_of() -> void const * { return &type_tag<T>::id; }
+
+/*********************************************************************************************************************
+ *
+ * argparse::stream_reader - values read from a file descriptor
+ *
+ * Splits the input at the delimiter while it is read in chunks of a fixed
+ * buffer. Values are delivered as soon as they are available, e.g. while
+ * a pipe is still written, and memory use is bounded by the buffer.
+ *
+ *********************************************************************************************************************/
+
+class stream_reader {
+  public:
+    // Maximum length of a single value
+    static constexpr size_t buffer_size = 65536;
+
+    stream_reader(int fd, char delim);
+
+    // Next value terminated by zero, only valid until the following call. Empty values are skipped. Returns nullptr
+    // at the end of the input or on failure.
+    auto next() -> char const *;
+
+    auto failed() const -> bool { return _failed; }
+    auto overflowed() const -> bool { return _overflowed; }
+
+  private:
+    int _fd;
+    char _delim;
+    std::unique_ptr<char[]> _buffer; // One byte more than read at once, thus the last value can be terminated
+    size_t _begin = 0;
+    size_t _end = 0;
+    bool _eof = false;
+    bool _failed = false;
+    bool _overflowed = false;
+};
 
 /*********************************************************************************************************************
  *
@@ -67,6 +522,7 @@ template <> auto parse(char const *const s) -> std::string;
 class optional {
   public:
     optional(char _short, std::string_view _long, std::string_view _desc);
+    optional(char _short, std::string_view _long, std::string_view _desc, arg_kind kind, void const *type = nullptr);
     virtual ~optional();
 
     optional(optional &&) = delete;
@@ -80,11 +536,26 @@ class optional {
 
     virtual auto takes() -> size_t = 0;
     virtual auto parse(char const *const *argv, int argc) -> int;
+    virtual auto reset() -> void = 0;
+
+    // Returns the first of the given values that can't be converted, used to validate values stored into a result
+    virtual auto find_invalid(char const *const *argv, size_t len) const -> char const *;
 
   protected:
+    friend class command;
+    friend class parser;
+    friend class result;
+
+    auto invalid(std::string_view value) const -> void;
+    auto overflow() const -> void;
+
     char _short;
     std::string_view _long;
     std::string_view _desc;
+    bool _touched;
+    arg_kind _kind;
+    void const *_type; // Concrete class, see type_of
+    size_t _id;
 };
 
 /*********************************************************************************************************************
@@ -104,8 +575,14 @@ class optional_flag : public optional {
     auto cnt() const -> size_t;
     auto is_set() const -> bool;
 
+    auto add() -> void {
+        _flag = true;
+        _cnt += 1;
+    }
+
     auto takes() -> size_t override;
     auto parse(char const *const *argv, int len) -> int override;
+    auto reset() -> void override;
 
   private:
     size_t _cnt;
@@ -123,7 +600,8 @@ class optional_flag : public optional {
 
 template <typename T> class optional_value : public optional {
   public:
-    optional_value(char _short, std::string_view _long, std::string_view _desc) : optional(_short, _long, _desc) {}
+    optional_value(char _short, std::string_view _long, std::string_view _desc)
+        : optional(_short, _long, _desc, arg_kind::value, type_of<optional_value<T>>()) {}
 
     auto get_value() const -> T const * { return std::get_if<T>(&_value); }
 
@@ -132,9 +610,19 @@ template <typename T> class optional_value : public optional {
         if (len < 1) {
             return -1;
         }
-        _value = argparse::parse<T>(argv[0]);
+        auto value = T();
+        if (!converter<T>::convert(argv[0], value)) {
+            invalid(argv[0]);
+            return -1;
+        }
+        _value = std::move(value);
         return 1;
     }
+    auto reset() -> void override { _value = std::monostate(); }
+
+    auto find_invalid(char const *const *argv, size_t len) const -> char const * override {
+        return argparse::find_invalid<T>(argv, std::min<size_t>(len, 1));
+    }
 
   private:
     std::variant<std::monostate, T> _value;
@@ -152,26 +640,41 @@ template <typename T> class optional_value : public optional {
 template <typename T> class optional_list : public optional {
   public:
     optional_list(char _short, std::string_view _long, std::string_view _desc)
-        : optional(_short, _long, _desc), _values() {}
+        : optional(_short, _long, _desc, arg_kind::list, type_of<optional_list<T>>()),
+          _values() {}
+    optional_list(char _short, std::string_view _long, std::string_view _desc, std::pmr::memory_resource *resource)
+        : optional(_short, _long, _desc, arg_kind::list, type_of<optional_list<T>>()),
+          _values(resource) {}
+    optional_list(char _short, std::string_view _long, std::string_view _desc, std::span<T> storage)
+        : optional(_short, _long, _desc, arg_kind::list, type_of<optional_list<T>>()),
+          _values(storage) {}
 
-    auto get_values() const -> std::vector<T> const & { return _values; }
+    auto get_values() const -> std::span<T const> { return _values.values(); }
 
     auto takes() -> size_t override { return std::numeric_limits<size_t>::max(); }
     auto parse(char const *const *argv, int len) -> int override {
         if (len < 1) {
             return -1;
         }
-        auto cnt = 0;
-        for (const auto &v : std::span(argv, len)) {
-            _values.push_back(argparse::parse<T>(v));
-            cnt += 1;
+        if (static_cast<size_t>(len) > _values.available()) {
+            overflow();
+            return -1;
+        }
+        auto cnt = _values.append(argv, len);
+        if (cnt < len) {
+            invalid(argv[cnt]);
+            return -1;
         }
-
         return cnt;
     }
+    auto reset() -> void override { _values.clear(); }
+
+    auto find_invalid(char const *const *argv, size_t len) const -> char const * override {
+        return argparse::find_invalid<T>(argv, len);
+    }
 
   private:
-    std::vector<T> _values;
+    list_storage<T> _values;
 };
 
 /*********************************************************************************************************************
@@ -186,6 +689,7 @@ template <typename T> class optional_list : public optional {
 class argument {
   public:
     argument(std::string_view _name, std::string_view _desc);
+    argument(std::string_view _name, std::string_view _desc, arg_kind kind, void const *type = nullptr);
     virtual ~argument();
 
     argument(argument &&) = delete;
@@ -199,10 +703,40 @@ class argument {
 
     virtual auto takes() -> size_t = 0;
     virtual auto parse(char const *const *argv, int len) -> int;
+    virtual auto reset() -> void = 0;
+
+    // Returns the first of the given values that can't be converted, used to validate values stored into a result
+    virtual auto find_invalid(char const *const *argv, size_t len) const -> char const *;
 
   protected:
+    friend class command;
+    friend class parser;
+    friend class result;
+
+    auto invalid(std::string_view value) const -> void;
+    auto overflow() const -> void;
+    auto unreadable(stream_reader const &reader) const -> void;
+
+    // Maximum number of values taken, without virtual call for the known kinds
+    auto limit() -> size_t {
+        switch (_kind) {
+        case arg_kind::value:
+            return 1;
+        case arg_kind::list:
+        case arg_kind::stream:
+        case arg_kind::command:
+            return std::numeric_limits<size_t>::max();
+        default:
+            return takes();
+        }
+    }
+
     std::string_view _name;
     std::string_view _desc;
+    bool _touched;
+    arg_kind _kind;
+    void const *_type; // Concrete class, see type_of
+    size_t _id;
 };
 
 /*********************************************************************************************************************
@@ -216,7 +750,8 @@ class argument {
 
 template <typename T> class required_value : public argument {
   public:
-    required_value(std::string_view _name, std::string_view _desc) : argument(_name, _desc) {}
+    required_value(std::string_view _name, std::string_view _desc)
+        : argument(_name, _desc, arg_kind::value, type_of<required_value<T>>()) {}
 
     auto get_value() const -> T const * { return std::get_if<T>(&_value); }
 
@@ -225,9 +760,19 @@ template <typename T> class required_value : public argument {
         if (len < 1) {
             return -1;
         }
-        _value = argparse::parse<T>(argv[0]);
+        auto value = T();
+        if (!converter<T>::convert(argv[0], value)) {
+            invalid(argv[0]);
+            return -1;
+        }
+        _value = std::move(value);
         return 1;
     }
+    auto reset() -> void override { _value = std::monostate(); }
+
+    auto find_invalid(char const *const *argv, size_t len) const -> char const * override {
+        return argparse::find_invalid<T>(argv, std::min<size_t>(len, 1));
+    }
 
   private:
     std::string_view _name;
@@ -245,27 +790,152 @@ template <typename T> class required_value : public argument {
 
 template <typename T> class required_list : public argument {
   public:
-    required_list(std::string_view _name, std::string_view _desc) : argument(_name, _desc), _values() {}
+    required_list(std::string_view _name, std::string_view _desc)
+        : argument(_name, _desc, arg_kind::list, type_of<required_list<T>>()), _values() {}
+    required_list(std::string_view _name, std::string_view _desc, std::pmr::memory_resource *resource)
+        : argument(_name, _desc, arg_kind::list, type_of<required_list<T>>()), _values(resource) {}
+    required_list(std::string_view _name, std::string_view _desc, std::span<T> storage)
+        : argument(_name, _desc, arg_kind::list, type_of<required_list<T>>()), _values(storage) {}
 
-    auto get_values() const -> std::vector<T> const & { return _values; }
+    auto get_values() const -> std::span<T const> { return _values.values(); }
 
     auto takes() -> size_t override { return std::numeric_limits<size_t>::max(); }
     auto parse(char const *const *argv, int len) -> int override {
         if (len < 1) {
             return -1;
         }
+        if (static_cast<size_t>(len) > _values.available()) {
+            overflow();
+            return -1;
+        }
+        auto cnt = _values.append(argv, len);
+        if (cnt < len) {
+            invalid(argv[cnt]);
+            return -1;
+        }
+        return cnt;
+    }
+    auto reset() -> void override { _values.clear(); }
+
+    auto find_invalid(char const *const *argv, size_t len) const -> char const * override {
+        return argparse::find_invalid<T>(argv, len);
+    }
+
+  private:
+    list_storage<T> _values;
+};
+
+/*********************************************************************************************************************
+ *
+ * argparse::required_stream - specialization of argument for unbounded value lists
+ *
+ * An instance of this class takes the values given on the commandline or,
+ * if none or only "-" is given, reads them from a file descriptor after
+ * parsing. Each value is converted and handed to a callback, thus any
+ * number of values is processed without storing them. It has to be the
+ * last argument of its command.
+ *
+ *********************************************************************************************************************/
 
-        auto cnt = 0;
-        for (const auto &v : std::span(argv, len)) {
+template <typename T> class required_stream : public argument {
+  public:
+    required_stream(std::string_view _name, std::string_view _desc)
+        : argument(_name, _desc, arg_kind::stream, type_of<required_stream<T>>()) {}
+
+    // Calls `fn` with each value, values read from `fd` are terminated by `delim`. Values of type std::string_view
+    // are only valid during the call. `fn` may return false to stop. Returns false if a value is invalid or the
+    // input can't be read.
+    template <typename Fn> auto read(int fd, Fn &&fn, char delim = '\n') const -> bool {
+        return deliver(_values, fd, delim, fn);
+    }
 
-            _values.push_back(argparse::parse<T>(v));
-            cnt += 1;
+    auto takes() -> size_t override { return std::numeric_limits<size_t>::max(); }
+    auto parse(char const *const *argv, int len) -> int override {
+        if (len < 1) {
+            return -1;
         }
-        return cnt;
+        if (auto const *value = find_invalid(argv, len); value != nullptr) {
+            invalid(value);
+            return -1;
+        }
+        _values = std::span(argv, len);
+        return len;
+    }
+    auto reset() -> void override { _values = {}; }
+
+    // A single "-" selects the file descriptor and is never converted
+    auto find_invalid(char const *const *argv, size_t len) const -> char const * override {
+        return len == 1 && std::string_view(argv[0]) == "-" ? nullptr : argparse::find_invalid<T>(argv, len);
     }
 
   private:
-    std::vector<T> _values;
+    friend class result;
+
+    template <typename Fn>
+    auto deliver(std::span<char const *const> values, int fd, char delim, Fn &fn) const -> bool {
+        // Returns false if the value is invalid, `stop` is set if requested by the callback
+        auto emit = [this, &fn](char const *value, bool &stop) -> bool {
+            auto converted = T();
+            if (!converter<T>::convert(value, converted)) {
+                invalid(value);
+                return false;
+            }
+            auto const &arg = converted;
+            if constexpr (std::same_as<std::invoke_result_t<Fn &, T const &>, bool>) {
+                stop = !fn(arg);
+            } else {
+                fn(arg);
+            }
+            return true;
+        };
+
+        auto stop = false;
+        if (values.size() > 1 || (values.size() == 1 && std::string_view(values[0]) != "-")) {
+            for (auto const *value : values) {
+                if (!emit(value, stop)) {
+                    return false;
+                }
+                if (stop) {
+                    break;
+                }
+            }
+            return true;
+        }
+
+        auto reader = stream_reader(fd, delim);
+        while (auto const *value = reader.next()) {
+            if (!emit(value, stop)) {
+                return false;
+            }
+            if (stop) {
+                return true;
+            }
+        }
+        if (reader.failed()) {
+            unreadable(reader);
+            return false;
+        }
+        return true;
+    }
+
+    std::span<char const *const> _values;
+};
+
+/*********************************************************************************************************************
+ *
+ * argparse::option_record - parse data of an option
+ *
+ * Each command stores the records of its options contiguously in order of
+ * addition and both lookup tables hold positions into them. The parse
+ * loop switches on the kind of the record found, thus flags are counted
+ * without reaching the node. Only values are converted or validated by it.
+ *
+ *********************************************************************************************************************/
+
+struct option_record {
+    arg_kind kind;
+    size_t id;
+    optional *node;
 };
 
 /*********************************************************************************************************************
@@ -283,7 +953,8 @@ class command : public argument {
     friend class argparse;
 
   public:
-    command(std::string_view _name, std::string_view _desc);
+    command(std::string_view _name, std::string_view _desc,
+            std::pmr::memory_resource *resource = std::pmr::get_default_resource());
 
     auto add_opt_flag(char const flag, std::string_view const long_flag,
                       std::string_view description) -> optional_flag const & {
@@ -302,16 +973,49 @@ class command : public argument {
         return add_optional_arg<optional_list<T>>(flag, long_flag, description);
     }
 
+    // The values are allocated from the given memory resource
+    template <typename T>
+    auto add_opt_list(char const flag, std::string_view const long_flag, std::string_view description,
+                      std::pmr::memory_resource *resource) -> optional_list<T> const & {
+        return add_optional_arg<optional_list<T>>(flag, long_flag, description, resource);
+    }
+
+    // The values are converted into the given storage, values exceeding its size fail the parse run
     template <typename T>
-    auto add_req_value(std::string_view const name, std::string_view const description) -> optional_value<T> const & {
+    auto add_opt_list(char const flag, std::string_view const long_flag, std::string_view description,
+                      std::span<T> storage) -> optional_list<T> const & {
+        return add_optional_arg<optional_list<T>>(flag, long_flag, description, storage);
+    }
+
+    template <typename T>
+    auto add_req_value(std::string_view const name, std::string_view const description) -> required_value<T> const & {
         return add_required_arg<required_value<T>>(name, description);
     }
 
     template <typename T>
-    auto add_req_list(std::string_view const name, std::string_view const description) -> optional_list<T> const & {
+    auto add_req_list(std::string_view const name, std::string_view const description) -> required_list<T> const & {
         return add_required_arg<required_list<T>>(name, description);
     }
 
+    template <typename T>
+    auto add_req_list(std::string_view const name, std::string_view const description,
+                      std::pmr::memory_resource *resource) -> required_list<T> const & {
+        return add_required_arg<required_list<T>>(name, description, resource);
+    }
+
+    template <typename T>
+    auto add_req_list(std::string_view const name, std::string_view const description, std::span<T> storage)
+        -> required_list<T> const & {
+        return add_required_arg<required_list<T>>(name, description, storage);
+    }
+
+    // Values are delivered by `read(..)` of the returned stream, it has to be the last required argument
+    template <typename T>
+    auto add_req_stream(std::string_view const name, std::string_view const description)
+        -> required_stream<T> const & {
+        return add_required_arg<required_stream<T>>(name, description);
+    }
+
     template <typename T>
     auto add_req_list(char const flag, std::string_view const long_flag,
                       std::string_view description) -> optional_list<T> const & {
@@ -339,67 +1043,288 @@ class command : public argument {
     }
 
     auto takes() -> size_t override;
+    auto reset() -> void override;
 
     auto add_command(std::string_view name, std::string_view desc) -> command &;
 
-  protected:
-    std::string _base;
-    std::vector<std::unique_ptr<optional>> _optional;
-    std::vector<std::unique_ptr<argument>> _required;
-    std::vector<std::unique_ptr<command>> _commands;
+    // Renders the help message into the buffer, returns the length of the complete message
+    auto render_help(std::span<char> buffer) const -> size_t;
+    auto render_help(std::string &out) const -> void;
 
+  protected:
+    // Shared by all nodes of a tree and owned by the root. The ids index the storage of argparse::result.
+    struct tree {
+        explicit tree(std::pmr::memory_resource *resource) : resource(resource), state(resource) {}
+
+        size_t optionals = 0;
+        size_t arguments = 0;
+        size_t commands = 1;
+        argparse::stats counters;
+        std::pmr::memory_resource *resource;
+        size_t columns = 0; // Line width of help messages, 0 if detected
+        parse_state state;  // State of parse runs without result
+    };
+
+    std::pmr::string _base;
+    tree _own_tree;
+    tree *_tree;
+    std::pmr::vector<node_ptr<optional>> _optional;
+    std::pmr::vector<option_record> _records; // Parallel to _optional
+    std::pmr::vector<node_ptr<argument>> _required;
+    std::pmr::vector<node_ptr<command>> _commands;
+    std::pmr::unordered_map<std::string_view, uint32_t> _long_index; // Positions in _records
+    std::pmr::unordered_map<std::string_view, argument *> _required_index;
+    std::pmr::unordered_map<std::string_view, command *> _command_index;
+    std::array<uint32_t, 256> _short_index{}; // Positions in _records plus one, 0 if unused
+
+    // Rendered help message, built on first use and valid as long as the line width is unchanged. Guarded by a
+    // mutex shared by all commands since parse runs into results may request it concurrently.
+    mutable std::pmr::string _help;
+    mutable size_t _help_columns = 0; // Line width of the rendered message, 0 if outdated
+
+    auto help_columns() const -> size_t;
     auto show_help() const -> void;
+    auto cached_help(size_t columns) const -> std::string_view;
+    auto render_help(help_text &out, size_t columns) const -> void;
+    auto drop_help() -> void;
 
     void set_base(std::string_view base);
 
     auto parse(char const *const *argv, int argc) -> int override;
+    auto parse(char const *const *argv, std::span<token const> tokens, parse_state &state) -> int;
+    auto parse(char const *const *argv, std::span<token const> tokens, result &res) const -> int;
 
   private:
-    template <typename Opt>
-    auto add_optional_arg(char const _short, std::string_view _long, std::string_view _desc) -> Opt const & {
-        auto opt = std::make_unique<Opt>(_short, _long, _desc);
-        if (std::ranges::any_of(_optional.begin(), _optional.end(), [_short, _long](auto &ptr) -> bool {
-                auto [s, l] = ptr->abbr();
-                return s == _short || l == _long;
-            })) {
+    // Receivers of the values, either the nodes themselves or a result
+    struct node_sink;
+    struct result_sink;
+
+    // Parse loop shared by both paths, only the parse run without result passes a mutable command
+    template <typename Self, typename Sink>
+    static auto parse_tokens(Self &self, char const *const *argv, std::span<token const> tokens, Sink &sink) -> int;
+
+    auto find_command(std::string_view name, argparse::stats &st) const -> command *;
+    auto find_optional(std::string_view arg, argparse::stats &st) const -> option_record const *;
+
+    template <typename Opt, typename... Args>
+    auto add_optional_arg(char const _short, std::string_view _long, std::string_view _desc, Args &&...args)
+        -> Opt const & {
+        ARGPARSE_STATS_TIME(_tree->counters.build_ns);
+        ARGPARSE_STATS_ADD(_tree->counters.comparisons, 1);
+        ARGPARSE_STATS_ADD(_tree->counters.nodes, 1);
+        ARGPARSE_STATS_ADD(_tree->counters.bytes, sizeof(Opt));
+        auto opt = make_node<Opt>(_tree->resource, _short, _long, _desc, std::forward<Args>(args)...);
+        auto &slot = _short_index[static_cast<unsigned char>(_short)];
+        if (slot != 0 || _long_index.contains(_long)) {
             auto msg = std::string("Duplicated optional argument for ") + _short + "/" + _long.data();
             throw std::runtime_error(msg);
         }
+        opt->_id = _tree->optionals++;
+        auto pos = static_cast<uint32_t>(_records.size());
+        _records.push_back(option_record{opt->_kind, opt->_id, opt.get()});
+        _long_index.emplace(_long, pos);
+        slot = pos + 1;
         _optional.push_back(std::move(opt));
+        _help_columns = 0;
         return *reinterpret_cast<Opt *>(_optional.back().get());
     }
 
-    template <typename Arg> auto add_required_arg(std::string_view _name, std::string_view _desc) {
-        auto arg = std::make_unique<Arg>(_name, _desc);
-        if (std::ranges::any_of(_required.begin(), _required.end(),
-                                [_name](auto &ptr) -> bool { return _name == ptr->name(); })) {
+    template <typename Arg, typename... Args>
+    auto add_required_arg(std::string_view _name, std::string_view _desc, Args &&...args) -> Arg const & {
+        ARGPARSE_STATS_TIME(_tree->counters.build_ns);
+        ARGPARSE_STATS_ADD(_tree->counters.comparisons, 1);
+        ARGPARSE_STATS_ADD(_tree->counters.nodes, 1);
+        ARGPARSE_STATS_ADD(_tree->counters.bytes, sizeof(Arg));
+        if (!_required.empty() && _required.back()->_kind == arg_kind::stream) {
+            auto msg = std::string("Required argument follows the stream argument: ") + _name.data();
+            throw std::runtime_error(msg);
+        }
+        auto arg = make_node<Arg>(_tree->resource, _name, _desc, std::forward<Args>(args)...);
+        if (!_required_index.emplace(arg->name(), arg.get()).second) {
             auto msg = std::string("Duplicated required argument for ") + _name.data();
             throw std::runtime_error(msg);
         }
+        arg->_id = _tree->arguments++;
         _required.push_back(std::move(arg));
+        _help_columns = 0;
+        return *static_cast<Arg *>(_required.back().get());
     }
 
+    // Lookups by name for the string based getters, the references returned on creation need none of them
     template <typename T> auto get_optional(std::string_view _long) -> T const & {
-        auto v = std::ranges::filter_view(std::span(_optional.begin(), _optional.end()), [_long](auto &ptr) -> bool {
-            auto [s, l] = ptr->abbr();
-            return l == _long;
-        });
-        if (v.empty()) {
-            abort();
+        auto it = _long_index.find(_long);
+        if (it == _long_index.end() || _records[it->second].node->_type != type_of<T>()) {
+            throw std::runtime_error(std::string("No optional argument of requested type for ") + _long.data());
         }
-        return *dynamic_cast<T const *>(v.begin()->get());
+        return *static_cast<T const *>(_records[it->second].node);
     }
 
     template <typename T> auto get_required(std::string_view _name) -> T const & {
-        auto v = std::ranges::filter_view(std::span(_required.begin(), _required.end()),
-                                          [_name](auto &ptr) -> bool { return ptr->name() == _name; });
-        if (v.empty()) {
-            abort();
+        auto it = _required_index.find(_name);
+        if (it == _required_index.end() || it->second->_type != type_of<T>()) {
+            throw std::runtime_error(std::string("No required argument of requested type for ") + _name.data());
         }
-        return *dynamic_cast<T const *>(v.begin()->get());
+        return *static_cast<T const *>(it->second);
     }
 };
 
+/*********************************************************************************************************************
+ *
+ * argparse::result - values of a single parse run
+ *
+ * A result stores the values gathered by parser::parse(argc, argv, result)
+ * apart from the argument definitions. The parser is only read, thus any
+ * number of threads can parse concurrently with one parser as long as each
+ * thread uses its own result. Values are converted on access.
+ *
+ *********************************************************************************************************************/
+
+class result {
+    // Converts a single value of a list, see convert(..)
+    template <typename T> struct convert_value {
+        auto operator()(char const *s) const -> T {
+            auto value = T();
+            converter<T>::convert(s, value);
+            return value;
+        }
+    };
+
+  public:
+    // Values of a list, each one is converted when accessed and the view is valid until the next parse run
+    template <typename T>
+    using values_view = std::ranges::transform_view<std::span<char const *const>, convert_value<T>>;
+
+    auto cnt(optional_flag const &flag) const -> size_t;
+    auto is_set(optional_flag const &flag) const -> bool;
+    auto is_set(command const &cmd) const -> bool;
+
+    // Statistics of all parse runs using this result
+    auto get_stats() const -> argparse::stats const &;
+
+    template <typename T> auto get_value(optional_value<T> const &opt) const -> std::optional<T> {
+        return convert<T>(find(_optionals, opt._id));
+    }
+
+    template <typename T> auto get_values(optional_list<T> const &opt) const -> values_view<T> {
+        return view_of<T>(find(_optionals, opt._id));
+    }
+
+    template <typename T> auto get_value(required_value<T> const &arg) const -> std::optional<T> {
+        return convert<T>(find(_arguments, arg._id));
+    }
+
+    template <typename T> auto get_values(required_list<T> const &arg) const -> values_view<T> {
+        return view_of<T>(find(_arguments, arg._id));
+    }
+
+    // Delivers the values of the stream, see required_stream::read(..)
+    template <typename T, typename Fn>
+    auto read(required_stream<T> const &arg, int fd, Fn &&fn, char delim = '\n') const -> bool {
+        auto const *e = find(_arguments, arg._id);
+        auto values = e == nullptr ? std::span<char const *const>() : std::span<char const *const>(e->values);
+        return arg.deliver(values, fd, delim, fn);
+    }
+
+  private:
+    friend class command;
+    friend class parser;
+
+    struct entry {
+        size_t cnt = 0;
+        std::vector<char const *> values;
+    };
+
+    std::vector<entry> _optionals;
+    std::vector<entry> _arguments;
+    std::vector<unsigned char> _commands;
+    std::vector<token> _tokens;
+    argparse::stats _stats;
+
+    std::vector<size_t> _touched_optionals;
+    std::vector<size_t> _touched_arguments;
+    std::vector<size_t> _touched_commands;
+
+    auto prepare(size_t optionals, size_t arguments, size_t commands) -> void;
+    auto store(option_record const &rec, char const *const *argv, int len) -> int;
+    auto store(argument &arg, char const *const *argv, int len) -> int;
+    auto set(command const &cmd) -> void;
+
+    static auto store(entry &e, std::vector<size_t> &touched, size_t id, size_t takes, char const *const *argv,
+                      int len) -> int;
+
+    static auto find(std::vector<entry> const &entries, size_t id) -> entry const * {
+        return id < entries.size() ? &entries[id] : nullptr;
+    }
+
+    // The values are validated while parsing, thus the conversion doesn't fail
+    template <typename T> static auto convert(entry const *e) -> std::optional<T> {
+        auto value = T();
+        if (e == nullptr || e->values.empty() || !converter<T>::convert(e->values.front(), value)) {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    template <typename T> static auto view_of(entry const *e) -> values_view<T> {
+        auto values = e == nullptr ? std::span<char const *const>() : std::span<char const *const>(e->values);
+        return values_view<T>(values, convert_value<T>());
+    }
+};
+
+/*********************************************************************************************************************
+ *
+ * argparse::response_args - commandline arguments with response files expanded
+ *
+ * Each argument `@file` is replaced by the arguments read from the file.
+ * These are separated by whitespace, may be quoted by single or double
+ * quotes and may name further response files by an unquoted leading `@`,
+ * a quoted or escaped `@` is kept literally. Regular files are mapped
+ * privately and tokenized in place, thus the parsed values reference the
+ * mapping without being copied. The instance has to outlive all of them.
+ *
+ *********************************************************************************************************************/
+
+class response_args {
+  public:
+    // Expands all response files given in argv, argv[0] is never expanded. The size of all response files together
+    // is limited to `limit` bytes, 0 if unlimited. Throws std::runtime_error if a file is unreadable or invalid.
+    response_args(int argc, char *argv[], size_t limit = 0);
+    ~response_args();
+
+    // Prevent unnecessary copy or move
+    response_args(response_args &&) = delete;
+    response_args(response_args const &) = delete;
+
+    auto operator=(response_args &&) -> response_args & = delete;
+    auto operator=(response_args const &) -> response_args & = delete;
+
+    auto argc() const -> int { return static_cast<int>(_argv.size()) - 1; }
+
+    // Expanded arguments, terminated by nullptr same as argv of main
+    auto argv() -> char ** { return _argv.data(); }
+
+  private:
+    struct region {
+        char *data;
+        size_t len; // Length including the terminating byte
+        bool mapped;
+        std::vector<char> heap;
+    };
+
+    auto add(char *arg, int depth) -> void;
+    auto expand(char const *path, int depth) -> void;
+    auto open(char const *path) -> region &;
+    auto read(char const *path, std::FILE *stream) -> region &;
+    auto tokenize(char const *path, char *data, size_t len, int depth) -> void;
+    auto reserve(char const *path, size_t size) -> void;
+    auto release() -> void;
+
+    std::vector<char *> _argv;
+    std::vector<region> _regions;
+    size_t _size = 0;
+    size_t _limit;
+};
+
 /*********************************************************************************************************************
  *
  * argparse::parser - CLI parser class
@@ -414,7 +1339,9 @@ class command : public argument {
 
 class parser : public command {
   public:
-    parser(std::string_view _name, std::string_view _desc);
+    // Options, arguments, commands and the state of parse runs are allocated from the memory resource
+    parser(std::string_view _name, std::string_view _desc,
+           std::pmr::memory_resource *resource = std::pmr::get_default_resource());
     ~parser();
 
     // Prevent unnecessary copy or move
@@ -425,6 +1352,19 @@ class parser : public command {
     auto operator=(parser const &) -> parser & = delete;
 
     auto parse(int argc, char *argv[]) -> bool;
+
+    // Parses into the given result, the parser itself is not modified
+    auto parse(int argc, char *argv[], result &res) const -> bool;
+
+    // Clears only the arguments set by previous parse runs
+    auto reset() -> void override;
+
+    // Statistics of building the parser and of parse runs without result
+    auto get_stats() const -> argparse::stats const &;
+
+    // Line width of help messages, descriptions are wrapped at word boundaries to fit. 0 detects the width of the
+    // terminal connected to stdout, otherwise the COLUMNS environment variable or 80 is used.
+    auto set_columns(size_t columns) -> void;
 };
 
 } // namespace argparse
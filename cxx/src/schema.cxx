@@ -0,0 +1,127 @@
+/*********************************************************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2024 David Loewe
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************************************************/
+
+#include <iostream>
+
+#include "schema.hxx"
+
+/*********************************************************************************************************************
+ * argparse::schema implementation
+ *********************************************************************************************************************/
+
+namespace {
+
+auto render_path(argparse::help_text &out, argparse::schema::path const &p) -> void {
+    if (p.parent != nullptr) {
+        render_path(out, *p.parent);
+    }
+    out.put(p.name).put(' ');
+}
+
+} // namespace
+
+auto argparse::schema::show_help(path const &cmd, std::string_view desc, std::span<entry const> entries) -> void {
+    // Reused by all help messages of the thread, thus only grows for the largest one
+    thread_local auto buffer = std::pmr::string();
+    buffer.clear();
+    auto out = help_text(buffer);
+    render_help(out, cmd, desc, entries);
+    write_help(buffer);
+}
+
+auto argparse::schema::render_help(help_text &out, path const &cmd, std::string_view desc,
+                                   std::span<entry const> entries) -> void {
+    auto options = std::ranges::count_if(entries, is_option);
+    auto commands = std::ranges::count_if(entries, is_command);
+
+    out.columns(terminal_columns()).put("\n    Usage: ");
+    render_path(out, cmd);
+    if (options > 0) {
+        out.put("[OPTIONS] ");
+    }
+    if (commands > 0) {
+        out.put("[COMMAND] ");
+    }
+    for (auto const &e : entries) {
+        if (e.positional) {
+            out.put(e.name).put(' ');
+            if (e.kind == arg_kind::list) {
+                out.put('[').put(e.name).put("...] ");
+            }
+        }
+    }
+    out.put("\n\n");
+
+    if (!desc.empty()) {
+        out.put("    ").wrap(desc, 4).put("\n\n");
+    }
+
+    auto section = [&entries, &out](std::string_view title, auto pred, bool flags) {
+        size_t width = 4;
+        for (auto const &e : entries) {
+            if (pred(e)) {
+                width = std::max<size_t>(width, e.name.length() + 4);
+            }
+        }
+        out.put("    ").put(title).put(":\n\n");
+        for (auto const &e : entries) {
+            if (!pred(e)) {
+                continue;
+            }
+            out.put("        ");
+            if (flags) {
+                if (e.short_name != '\0') {
+                    out.put('-').put(e.short_name).put(", --");
+                } else {
+                    out.put("    --");
+                }
+            }
+            out.put(e.name).pad(width - e.name.length()).wrap(e.desc, 8 + (flags ? 6 : 0) + width).put('\n');
+        }
+        out.put('\n');
+    };
+
+    if (options > 0) {
+        section("Options", is_option, true);
+    }
+    if (commands > 0) {
+        section("Commands", is_command, false);
+        out.put("        See '<command> --help' for additional info.\n\n");
+    }
+    if (std::ranges::any_of(entries, is_positional)) {
+        section("Required", is_positional, false);
+    }
+}
+
+auto argparse::schema::report_invalid(std::string_view value, entry const &e) -> void {
+    if (e.positional) {
+        std::cerr << "Invalid value '" << value << "' for " << e.name << std::endl;
+    } else if (e.short_name != '\0') {
+        std::cerr << "Invalid value '" << value << "' for -" << e.short_name << ", --" << e.name << std::endl;
+    } else {
+        std::cerr << "Invalid value '" << value << "' for --" << e.name << std::endl;
+    }
+}
+
+/*********************************************************************************************************************/
@@ -0,0 +1,533 @@
+/*********************************************************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2024 David Loewe
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************************************************/
+
+#ifndef __ARGPARSE_SCHEMA_CXX__
+#define __ARGPARSE_SCHEMA_CXX__
+
+#include <bit>
+#include <tuple>
+#include <utility>
+
+#include "argparse.hxx"
+
+namespace argparse::schema {
+
+/*********************************************************************************************************************
+ *
+ * argparse::schema - CLI definition at compile time
+ *
+ * A schema describes a command with its options, arguments and nested
+ * commands as types. Names are validated at compile time and the lookup
+ * tables are generated as constant data, thus nothing is built at startup
+ * and parsing only reads static tables. The values are stored into the
+ * generated command::result and accessed by name.
+ *
+ *   using cli = argparse::schema::command<"app", "Description.",
+ *       argparse::schema::flag<'v', "verbose", "Enable verbosity.">,
+ *       argparse::schema::value<int, 'j', "jobs", "Number of jobs.">,
+ *       argparse::schema::args<std::string_view, "FILES", "Input files.">>;
+ *
+ *   auto res = cli::result();
+ *   if (cli::parse(argc, argv, res)) {
+ *       auto jobs = res.get<"jobs">().value_or(1);
+ *   }
+ *
+ *********************************************************************************************************************/
+
+template <size_t N> struct fixed_string {
+    char chars[N]{};
+
+    constexpr fixed_string(char const (&s)[N]) { std::copy_n(s, N, chars); }
+    constexpr auto view() const -> std::string_view { return {chars, N - 1}; }
+};
+
+// Description of an option, argument or command, used for lookup tables and help
+struct entry {
+    arg_kind kind;
+    bool positional;
+    char short_name;
+    std::string_view name;
+    std::string_view desc;
+};
+
+// Names from the root to the current command, lives on the stack of the parse run
+struct path {
+    path const *parent;
+    std::string_view name;
+};
+
+auto show_help(path const &cmd, std::string_view desc, std::span<entry const> entries) -> void;
+auto render_help(help_text &out, path const &cmd, std::string_view desc, std::span<entry const> entries) -> void;
+auto report_invalid(std::string_view value, entry const &e) -> void;
+
+/*********************************************************************************************************************
+ *
+ * argparse::schema::name_table - perfect hash of names
+ *
+ * Built at compile time with hash and displace: the names are grouped
+ * into buckets and each bucket gets a displacement that moves all of its
+ * names into free slots. A lookup hashes once and compares one name.
+ *
+ *********************************************************************************************************************/
+
+template <size_t N> struct name_table {
+    static constexpr size_t buckets = N == 0 ? 1 : N;
+    static constexpr size_t slots = std::bit_ceil(2 * N + 1);
+
+    std::array<std::string_view, N> names{};
+    std::array<uint16_t, N> ids{};
+    std::array<uint32_t, buckets> displacement{};
+    std::array<uint16_t, slots> index{}; // Position in names + 1, 0 is empty
+
+    static constexpr auto hash(std::string_view s) -> uint64_t {
+        auto h = uint64_t(0xcbf29ce484222325);
+        for (auto c : s) {
+            h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+        }
+        return h;
+    }
+
+    static constexpr auto slot(uint64_t h, uint32_t d) -> size_t {
+        auto x = h + d * uint64_t(0x9e3779b97f4a7c15);
+        x = (x ^ (x >> 33)) * 0xff51afd7ed558ccd;
+        return (x ^ (x >> 33)) & (slots - 1);
+    }
+
+    // Returns the id of the name or -1
+    constexpr auto find(std::string_view s) const -> int {
+        if constexpr (N == 0) {
+            return -1;
+        } else {
+            auto h = hash(s);
+            auto i = index[slot(h, displacement[h % buckets])];
+            return i != 0 && names[i - 1] == s ? ids[i - 1] : -1;
+        }
+    }
+};
+
+// Duplicated names result in an empty table, they are reported by the command
+template <size_t N>
+consteval auto make_table(std::array<std::string_view, N> names, std::array<uint16_t, N> ids) -> name_table<N> {
+    using table = name_table<N>;
+    auto t = table();
+    t.names = names;
+    t.ids = ids;
+
+    auto sorted = names;
+    std::ranges::sort(sorted);
+    if (std::ranges::adjacent_find(sorted) != sorted.end()) {
+        return t;
+    }
+
+    // Names ordered by bucket, the largest buckets are placed first while most slots are free
+    auto hashes = std::array<uint64_t, N>();
+    auto sizes = std::array<size_t, table::buckets>();
+    auto order = std::array<size_t, N>();
+    for (size_t i = 0; i < N; ++i) {
+        hashes[i] = table::hash(names[i]);
+        sizes[hashes[i] % table::buckets] += 1;
+        order[i] = i;
+    }
+    std::ranges::sort(order, [&](size_t a, size_t b) -> bool {
+        auto ba = hashes[a] % table::buckets;
+        auto bb = hashes[b] % table::buckets;
+        return sizes[ba] != sizes[bb] ? sizes[ba] > sizes[bb] : ba < bb;
+    });
+
+    for (size_t first = 0; first < N;) {
+        auto bucket = hashes[order[first]] % table::buckets;
+        auto last = first + sizes[bucket];
+        auto taken = std::array<size_t, N>();
+        for (uint32_t d = 0;; ++d) {
+            auto cnt = size_t(0);
+            for (auto i = first; i < last; ++i) {
+                auto s = table::slot(hashes[order[i]], d);
+                if (t.index[s] != 0 || std::find(taken.begin(), taken.begin() + cnt, s) != taken.begin() + cnt) {
+                    break;
+                }
+                taken[cnt++] = s;
+            }
+            if (cnt == last - first) {
+                for (auto i = first; i < last; ++i) {
+                    t.index[taken[i - first]] = static_cast<uint16_t>(order[i] + 1);
+                }
+                t.displacement[bucket] = d;
+                break;
+            }
+        }
+        first = last;
+    }
+    return t;
+}
+
+/*********************************************************************************************************************
+ *
+ * argparse::schema::flag/value/list/arg/args - options and arguments
+ *
+ * Each type describes one option or positional argument and converts its
+ * values with argparse::converter into the storage within the result.
+ * Flags count their occurrences, values are stored as std::optional<T>
+ * and lists as std::vector<T>.
+ *
+ *********************************************************************************************************************/
+
+template <char Short, fixed_string Long, fixed_string Desc> struct flag {
+    static constexpr entry info{arg_kind::flag, false, Short, Long.view(), Desc.view()};
+    using storage = size_t;
+
+    static auto store(storage &cnt, char const *const * /*argv*/, int /*len*/) -> int {
+        cnt += 1;
+        return 0;
+    }
+    static auto clear(storage &cnt) -> void { cnt = 0; }
+};
+
+template <typename T, arg_kind Kind, bool Positional, char Short, fixed_string Name, fixed_string Desc> struct typed {
+    static constexpr entry info{Kind, Positional, Short, Name.view(), Desc.view()};
+    using storage = std::conditional_t<Kind == arg_kind::value, std::optional<T>, std::vector<T>>;
+
+    static auto store(storage &s, char const *const *argv, int len) -> int {
+        if (len < 1) {
+            return -1;
+        }
+        if constexpr (Kind == arg_kind::value) {
+            auto value = T();
+            if (!converter<T>::convert(argv[0], value)) {
+                report_invalid(argv[0], info);
+                return -1;
+            }
+            s = std::move(value);
+            return 1;
+        } else {
+            auto size = s.size();
+            s.resize(size + len);
+            auto cnt = convert_values(s.data() + size, argv, len);
+            if (cnt < len) {
+                s.resize(size);
+                report_invalid(argv[cnt], info);
+                return -1;
+            }
+            return len;
+        }
+    }
+
+    static auto clear(storage &s) -> void {
+        if constexpr (Kind == arg_kind::value) {
+            s.reset();
+        } else {
+            s.clear();
+        }
+    }
+};
+
+template <typename T, char Short, fixed_string Long, fixed_string Desc>
+struct value : typed<T, arg_kind::value, false, Short, Long, Desc> {};
+
+template <typename T, char Short, fixed_string Long, fixed_string Desc>
+struct list : typed<T, arg_kind::list, false, Short, Long, Desc> {};
+
+template <typename T, fixed_string Name, fixed_string Desc>
+struct arg : typed<T, arg_kind::value, true, '\0', Name, Desc> {};
+
+template <typename T, fixed_string Name, fixed_string Desc>
+struct args : typed<T, arg_kind::list, true, '\0', Name, Desc> {};
+
+// Helpers to generate the tables of a command from its entries
+
+constexpr auto is_option(entry const &e) -> bool { return !e.positional && e.kind != arg_kind::command; }
+constexpr auto is_command(entry const &e) -> bool { return e.kind == arg_kind::command; }
+constexpr auto is_positional(entry const &e) -> bool { return e.positional; }
+
+template <size_t N> consteval auto index_of(std::array<entry, N> const &entries, std::string_view name) -> size_t {
+    for (size_t i = 0; i < N; ++i) {
+        if (entries[i].name == name) {
+            return i;
+        }
+    }
+    return N;
+}
+
+template <size_t N> consteval auto unique(std::array<entry, N> const &entries, auto same) -> bool {
+    for (size_t i = 0; i < N; ++i) {
+        for (size_t j = i + 1; j < N; ++j) {
+            if (same(entries[i], entries[j])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Ids of the entries matching the predicate, M is their count
+template <size_t M, size_t N>
+consteval auto ids_of(std::array<entry, N> const &entries, auto pred) -> std::array<uint16_t, M> {
+    auto ids = std::array<uint16_t, M>();
+    for (size_t i = 0, j = 0; i < N; ++i) {
+        if (pred(entries[i])) {
+            ids[j++] = static_cast<uint16_t>(i);
+        }
+    }
+    return ids;
+}
+
+template <size_t M, size_t N> consteval auto table_of(std::array<entry, N> const &entries, auto pred) -> name_table<M> {
+    auto ids = ids_of<M>(entries, pred);
+    auto names = std::array<std::string_view, M>();
+    for (size_t i = 0; i < M; ++i) {
+        names[i] = entries[ids[i]].name;
+    }
+    return make_table<M>(names, ids);
+}
+
+// Id + 1 of the option for each short flag, 0 if unused
+template <size_t N> consteval auto short_table(std::array<entry, N> const &entries) -> std::array<uint16_t, 256> {
+    auto table = std::array<uint16_t, 256>();
+    for (size_t i = 0; i < N; ++i) {
+        if (is_option(entries[i]) && entries[i].short_name != '\0') {
+            table[static_cast<unsigned char>(entries[i].short_name)] = static_cast<uint16_t>(i + 1);
+        }
+    }
+    return table;
+}
+
+/*********************************************************************************************************************
+ *
+ * argparse::schema::command - command with its options, arguments and subcommands
+ *
+ * The root of a schema is a command as well. Duplicated names, the
+ * reserved -h/--help and lists before further positional arguments are
+ * rejected at compile time.
+ *
+ *********************************************************************************************************************/
+
+template <fixed_string Name, fixed_string Desc, typename... Items> struct command {
+    static constexpr entry info{arg_kind::command, false, '\0', Name.view(), Desc.view()};
+    static constexpr std::array<entry, sizeof...(Items)> entries{Items::info...};
+
+    struct result {
+        bool set = false;
+        std::tuple<typename Items::storage...> values;
+
+        // Count of a flag, std::optional of a value, std::vector of a list or the result of a subcommand
+        template <fixed_string Key> auto get() const -> auto const & {
+            constexpr auto id = index_of(entries, Key.view());
+            static_assert(id < sizeof...(Items), "Unknown option, argument or command name");
+            return std::get<id>(values);
+        }
+    };
+    using storage = result;
+
+    // Parses the arguments, argv[0] is the program name. Previous values of the result are cleared.
+    static auto parse(int argc, char const *const *argv, result &res) -> bool {
+        clear(res);
+        return parse_from(argv, argc, res, nullptr) == argc;
+    }
+
+    // Renders the help message of this command as root into the buffer, returns the length of the complete message
+    static auto render_help(std::span<char> buffer) -> size_t {
+        auto out = help_text(buffer);
+        schema::render_help(out, path{nullptr, info.name}, info.desc, entries);
+        return out.size();
+    }
+
+    static auto clear(result &res) -> void {
+        res.set = false;
+        clear(res, std::index_sequence_for<Items...>());
+    }
+
+    // Parses the arguments following argv[0], which is the name of this command. Returns the consumed count or -1.
+    static auto parse_from(char const *const *argv, int argc, result &res, path const *parent) -> int {
+        auto here = path{parent, info.name};
+        res.set = true;
+
+        auto pos = 1;
+        while (pos < argc) {
+            auto arg = std::string_view(argv[pos]);
+            if (arg == "-h" || arg == "--help") {
+                show_help(here, info.desc, entries);
+                return -1;
+            }
+
+            if (arg.size() > 1 && arg[0] == '-' && arg != "--") {
+                auto end = words_end(argv, argc, pos + 1);
+                auto next = pos + 1;
+                auto handle = [&](int id) -> bool {
+                    auto used = id < 0 ? -1 : store(id, res, &argv[next], end - next);
+                    if (used < 0) {
+                        if (id >= 0) {
+                            show_help(here, info.desc, entries);
+                        }
+                        return false;
+                    }
+                    next += used;
+                    return true;
+                };
+
+                if (arg[1] == '-') {
+                    if (!handle(options.find(arg.substr(2)))) {
+                        return -1;
+                    }
+                } else {
+                    // Flags combined like `-vvv`, values are taken in order
+                    for (auto c : arg.substr(1)) {
+                        if (!handle(shorts[static_cast<unsigned char>(c)] - 1)) {
+                            return -1;
+                        }
+                    }
+                }
+                pos = next;
+                continue;
+            }
+
+            if (arg == "--") {
+                pos += 1;
+            } else if (auto id = commands.find(arg); id >= 0) {
+                auto used = enter(id, res, &argv[pos], argc - pos, &here);
+                if (used < 0) {
+                    return -1;
+                }
+                pos += used;
+                continue;
+            }
+
+            if (pos < argc) {
+                for (auto id : positionals) {
+                    if (pos >= argc) {
+                        return -1;
+                    }
+                    auto used = store(id, res, &argv[pos], argc - pos);
+                    if (used < 0) {
+                        return -1;
+                    }
+                    pos += used;
+                }
+                return pos;
+            }
+        }
+        return positionals.empty() ? pos : -1;
+    }
+
+  private:
+    template <size_t I> using item = std::tuple_element_t<I, std::tuple<Items...>>;
+
+    static_assert(sizeof...(Items) < std::numeric_limits<uint16_t>::max(), "Too many items in one command");
+    static_assert(unique(entries,
+                         [](entry const &a, entry const &b) -> bool {
+                             return is_option(a) && is_option(b) && a.short_name != '\0' &&
+                                    a.short_name == b.short_name;
+                         }),
+                  "Duplicated short flag");
+    static_assert(unique(entries,
+                         [](entry const &a, entry const &b) -> bool {
+                             return a.name == b.name && is_option(a) == is_option(b) && a.positional == b.positional;
+                         }),
+                  "Duplicated name of option, argument or command");
+    static_assert(std::ranges::none_of(entries,
+                                       [](entry const &e) -> bool {
+                                           return is_option(e) && (e.short_name == 'h' || e.name == "help");
+                                       }),
+                  "-h and --help are reserved for the help");
+    static_assert(std::ranges::none_of(entries,
+                                       [](entry const &e) -> bool {
+                                           return e.name.empty() || e.name.find(' ') != std::string_view::npos;
+                                       }),
+                  "Names must not be empty or contain spaces");
+
+    static constexpr auto option_count = std::ranges::count_if(entries, is_option);
+    static constexpr auto command_count = std::ranges::count_if(entries, is_command);
+    static constexpr auto positional_count = std::ranges::count_if(entries, is_positional);
+
+    static constexpr auto shorts = short_table(entries);
+    static constexpr auto options = table_of<option_count>(entries, is_option);
+    static constexpr auto commands = table_of<command_count>(entries, is_command);
+    static constexpr auto positionals = ids_of<positional_count>(entries, is_positional);
+
+    static_assert(std::ranges::none_of(positionals.begin(), positionals.end() - (positional_count > 0),
+                                       [](uint16_t id) -> bool { return entries[id].kind == arg_kind::list; }),
+                  "Only the last positional argument can be a list");
+
+    // End of the values following an option, they end at the next option or subcommand
+    static auto words_end(char const *const *argv, int argc, int start) -> int {
+        auto i = start;
+        while (i < argc && (argv[i][0] != '-' || argv[i][1] == '\0')) {
+            if constexpr (command_count > 0) {
+                if (commands.find(argv[i]) >= 0) {
+                    break;
+                }
+            }
+            ++i;
+        }
+        return i;
+    }
+
+    static auto store(size_t id, result &res, char const *const *argv, int len) -> int {
+        return store(id, res, argv, len, std::index_sequence_for<Items...>());
+    }
+
+    template <size_t... I>
+    static auto store(size_t id, result &res, char const *const *argv, int len, std::index_sequence<I...>) -> int {
+        auto used = -1;
+        (void)((id == I ? (used = store_item<I>(res, argv, len), true) : false) || ...);
+        return used;
+    }
+
+    template <size_t I> static auto store_item(result &res, char const *const *argv, int len) -> int {
+        if constexpr (item<I>::info.kind == arg_kind::command) {
+            return -1;
+        } else {
+            return item<I>::store(std::get<I>(res.values), argv, len);
+        }
+    }
+
+    static auto enter(size_t id, result &res, char const *const *argv, int argc, path const *here) -> int {
+        return enter(id, res, argv, argc, here, std::index_sequence_for<Items...>());
+    }
+
+    template <size_t... I>
+    static auto enter(size_t id, result &res, char const *const *argv, int argc, path const *here,
+                      std::index_sequence<I...>) -> int {
+        auto used = -1;
+        (void)((id == I ? (used = enter_item<I>(res, argv, argc, here), true) : false) || ...);
+        return used;
+    }
+
+    template <size_t I>
+    static auto enter_item(result &res, char const *const *argv, int argc, path const *here) -> int {
+        if constexpr (item<I>::info.kind == arg_kind::command) {
+            return item<I>::parse_from(argv, argc, std::get<I>(res.values), here);
+        } else {
+            return -1;
+        }
+    }
+
+    template <size_t... I> static auto clear(result &res, std::index_sequence<I...>) -> void {
+        (item<I>::clear(std::get<I>(res.values)), ...);
+    }
+};
+
+} // namespace argparse::schema
+
+#endif // __ARGPARSE_SCHEMA_CXX__
+
+/*********************************************************************************************************************/
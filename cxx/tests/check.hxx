@@ -0,0 +1,30 @@
+#ifndef __ARGPARSE_CXX_CHECK__
+#define __ARGPARSE_CXX_CHECK__
+
+#include <iostream>
+
+// Number of failed checks, each test returns it from main
+inline int failures = 0;
+
+// Reports a failed condition and continues, thus a single run lists all failures of the test
+#define CHECK(cond)                                                                                                    \
+    do {                                                                                                               \
+        if (!(cond)) {                                                                                                 \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " << #cond << std::endl;                      \
+            failures += 1;                                                                                             \
+        }                                                                                                              \
+    } while (0)
+
+// Compares two values printable to std::ostream
+#define CHECK_EQ(actual, expected)                                                                                     \
+    do {                                                                                                               \
+        auto const &a_ = (actual);                                                                                     \
+        auto const &e_ = (expected);                                                                                   \
+        if (!(a_ == e_)) {                                                                                             \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " << #actual << " is '" << a_                 \
+                      << "', expected '" << e_ << "'" << std::endl;                                                    \
+            failures += 1;                                                                                             \
+        }                                                                                                              \
+    } while (0)
+
+#endif // __ARGPARSE_CXX_CHECK__
@@ -0,0 +1,135 @@
+#include "argparse.hxx"
+#include "check.hxx"
+
+#include <array>
+#include <chrono>
+#include <stdexcept>
+
+// Converts the value, returns whether it succeeded and compares the result if so
+template <typename T> static auto converts(std::string_view s, T expected) -> bool {
+    auto value = T();
+    return argparse::convert(s, value) && value == expected;
+}
+
+template <typename T> static auto rejects(std::string_view s) -> bool {
+    auto value = T();
+    return !argparse::convert(s, value);
+}
+
+// Limits and sign of each integer width, hexadecimal and garbage
+static auto test_integers() -> void {
+    CHECK(converts<int8_t>("127", 127));
+    CHECK(converts<int8_t>("-128", -128));
+    CHECK(rejects<int8_t>("128"));
+    CHECK(rejects<int8_t>("-129"));
+    CHECK(converts<uint8_t>("255", 255));
+    CHECK(rejects<uint8_t>("256"));
+    CHECK(rejects<uint8_t>("-1"));
+    CHECK(converts<int16_t>("-32768", -32768));
+    CHECK(rejects<int16_t>("32768"));
+    CHECK(converts<uint32_t>("4294967295", 4294967295U));
+    CHECK(rejects<uint32_t>("4294967296"));
+    CHECK(converts<int>("0x1F", 31));
+    CHECK(converts<int>("0", 0));
+    CHECK(rejects<int>(""));
+    CHECK(rejects<int>("-"));
+    CHECK(rejects<int>("0x"));
+    CHECK(rejects<int>("12a"));
+    CHECK(rejects<int>("1 "));
+    CHECK(rejects<int>("1.5"));
+}
+
+static auto test_floats() -> void {
+    CHECK(converts<double>("1.5", 1.5));
+    CHECK(converts<double>("-2", -2.0));
+    CHECK(converts<double>("1e3", 1000.0));
+    CHECK(converts<float>("0.25", 0.25F));
+    CHECK(rejects<double>(""));
+    CHECK(rejects<double>("abc"));
+    CHECK(rejects<double>("1.5x"));
+}
+
+static auto test_bool() -> void {
+    for (auto s : {"true", "YES", "On", "1"}) {
+        CHECK(converts<bool>(s, true));
+    }
+    for (auto s : {"false", "No", "OFF", "0"}) {
+        CHECK(converts<bool>(s, false));
+    }
+    CHECK(rejects<bool>("maybe"));
+    CHECK(rejects<bool>(""));
+}
+
+// String views reference the argument itself
+static auto test_strings() -> void {
+    char const *arg = "value";
+    auto view = std::string_view();
+    CHECK(argparse::convert(arg, view));
+    CHECK(view.data() == arg);
+    CHECK(converts<std::string>("value", std::string("value")));
+}
+
+// A value without suffix is given in the unit of the duration
+static auto test_durations() -> void {
+    using namespace std::chrono_literals;
+    CHECK(converts<std::chrono::milliseconds>("250", 250ms));
+    CHECK(converts<std::chrono::milliseconds>("1.5s", 1500ms));
+    CHECK(converts<std::chrono::milliseconds>("2min", 120000ms));
+    CHECK(converts<std::chrono::seconds>("1h", 3600s));
+    CHECK(converts<std::chrono::microseconds>("3us", 3us));
+    CHECK(converts<std::chrono::nanoseconds>("7ns", 7ns));
+    CHECK(rejects<std::chrono::seconds>("1x"));
+    CHECK(rejects<std::chrono::seconds>("s"));
+    CHECK(rejects<std::chrono::duration<int8_t>>("1000"));
+}
+
+static auto test_byte_sizes() -> void {
+    auto size = [](std::string_view s) -> uint64_t {
+        auto value = argparse::byte_size{~uint64_t(0)};
+        return argparse::convert(s, value) ? value.bytes : ~uint64_t(0);
+    };
+    CHECK_EQ(size("10"), uint64_t(10));
+    CHECK_EQ(size("10B"), uint64_t(10));
+    CHECK_EQ(size("512K"), uint64_t(512) << 10);
+    CHECK_EQ(size("64MiB"), uint64_t(64) << 20);
+    CHECK_EQ(size("1kb"), uint64_t(1000));
+    CHECK_EQ(size("2GB"), uint64_t(2000000000));
+    CHECK_EQ(size("1TiB"), uint64_t(1) << 40);
+    CHECK_EQ(size("1XB"), ~uint64_t(0));
+    CHECK_EQ(size("MiB"), ~uint64_t(0));
+    CHECK_EQ(size("20000000TiB"), ~uint64_t(0));
+}
+
+// parse<T> throws, the parser reports the invalid value and fails
+static auto test_failures() -> void {
+    auto threw = false;
+    try {
+        argparse::parse<int>("x");
+    } catch (std::invalid_argument const &) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK_EQ(argparse::parse<int>("42"), 42);
+
+    auto parser = argparse::parser("test", "Failures.");
+    auto &timeout = parser.add_opt_value<std::chrono::seconds>('t', "timeout", "Timeout.");
+    auto invalid = std::array<char const *, 3>{"test", "-t", "soon"};
+    CHECK(!parser.parse(3, const_cast<char **>(invalid.data())));
+    CHECK(timeout.get_value() == nullptr);
+    parser.reset();
+
+    auto valid = std::array<char const *, 3>{"test", "-t", "2min"};
+    CHECK(parser.parse(3, const_cast<char **>(valid.data())));
+    CHECK(timeout.get_value() != nullptr && *timeout.get_value() == std::chrono::seconds(120));
+}
+
+int main() {
+    test_integers();
+    test_floats();
+    test_bool();
+    test_strings();
+    test_durations();
+    test_byte_sizes();
+    test_failures();
+    return failures == 0 ? 0 : 1;
+}
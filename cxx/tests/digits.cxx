@@ -0,0 +1,134 @@
+#include "argparse.hxx"
+#include "check.hxx"
+
+#include <array>
+#include <string>
+#include <vector>
+
+// Digits of the given length, each position differs to detect swapped or dropped lanes
+static auto digits(size_t len) -> std::string {
+    auto s = std::string();
+    for (size_t i = 0; i < len; ++i) {
+        s.push_back(static_cast<char>('1' + (i * 7) % 9));
+    }
+    return s;
+}
+
+static auto reference(std::string_view s) -> uint64_t {
+    auto value = uint64_t(0);
+    for (auto c : s) {
+        value = value * 10 + static_cast<uint64_t>(c - '0');
+    }
+    return value;
+}
+
+// Each length up to 16 digits fits into a single vector, longer ones take the scalar loop
+static auto test_lengths() -> void {
+    for (size_t len = 1; len <= 19; ++len) {
+        auto s = digits(len);
+        auto value = uint64_t(0);
+        CHECK(argparse::parse_digits(s, value));
+        CHECK_EQ(value, reference(s));
+    }
+    auto value = uint64_t(0);
+    CHECK(!argparse::parse_digits("", value));
+    CHECK(!argparse::parse_digits(digits(20), value));
+    CHECK(argparse::parse_digits("0000000000000042", value));
+    CHECK_EQ(value, uint64_t(42));
+    CHECK(argparse::parse_digits("9999999999999999", value));
+    CHECK_EQ(value, uint64_t(9999999999999999));
+    CHECK(argparse::parse_digits("99999999999999999", value));
+    CHECK_EQ(value, uint64_t(99999999999999999));
+    CHECK(argparse::parse_digits("9999999999999999999", value));
+    CHECK_EQ(value, uint64_t(9999999999999999999U));
+}
+
+// Characters next to '0' and '9' are rejected at every position of 16 and 17 digits
+static auto test_invalid() -> void {
+    for (size_t len : {size_t(16), size_t(17)}) {
+        for (size_t pos = 0; pos < len; ++pos) {
+            for (auto c : {'/', ':', ' ', '-', 'a', '\xb0'}) {
+                auto s = digits(len);
+                s[pos] = c;
+                auto value = uint64_t(0);
+                CHECK(!argparse::parse_digits(s, value));
+            }
+        }
+    }
+}
+
+// Sign and overflow around the limits of 64 bit integers, on both sides of 16 digits
+static auto test_limits() -> void {
+    auto check = [](std::string_view s, auto expected) {
+        auto value = decltype(expected)();
+        CHECK(argparse::convert(s, value));
+        CHECK_EQ(value, expected);
+    };
+    auto fails = [](std::string_view s, auto type) {
+        auto value = type;
+        CHECK(!argparse::convert(s, value));
+    };
+
+    check("1234567890123456", int64_t(1234567890123456));
+    check("-1234567890123456", int64_t(-1234567890123456));
+    check("12345678901234567", int64_t(12345678901234567));
+    check("-12345678901234567", int64_t(-12345678901234567));
+    check("9223372036854775807", std::numeric_limits<int64_t>::max());
+    check("-9223372036854775808", std::numeric_limits<int64_t>::min());
+    fails("9223372036854775808", int64_t());
+    fails("-9223372036854775809", int64_t());
+    check("18446744073709551615", std::numeric_limits<uint64_t>::max());
+    fails("18446744073709551616", uint64_t());
+    fails("-1234567890123456", uint64_t());
+    check("2147483647", std::numeric_limits<int32_t>::max());
+    check("-2147483648", std::numeric_limits<int32_t>::min());
+    fails("2147483648", int32_t());
+    fails("1234567890123456", int32_t());
+}
+
+// Lists convert all values at once, a single invalid value fails the whole list
+static auto test_lists() -> void {
+    auto storage = std::vector<std::string>();
+    for (auto i = 0; i < 5000; ++i) {
+        storage.push_back(std::to_string(i * 1000003LL));
+    }
+    auto argv = std::vector<char const *>{"test", "-l"};
+    for (auto const &s : storage) {
+        argv.push_back(s.c_str());
+    }
+
+    auto parser = argparse::parser("test", "Lists.");
+    auto &list = parser.add_opt_list<int64_t>('l', "list", "Values.");
+    CHECK(parser.parse(static_cast<int>(argv.size()), const_cast<char **>(argv.data())));
+    CHECK_EQ(list.get_values().size(), size_t(5000));
+    auto equal = true;
+    for (auto i = 0; i < 5000; ++i) {
+        equal = equal && list.get_values()[i] == i * 1000003LL;
+    }
+    CHECK(equal);
+    parser.reset();
+
+    argv[4000] = "12x";
+    CHECK(!parser.parse(static_cast<int>(argv.size()), const_cast<char **>(argv.data())));
+    CHECK(list.get_values().empty());
+
+    // Values exceeding the caller provided storage fail the run
+    auto fixed = std::array<int, 2>{};
+    auto small = argparse::parser("test", "Storage.");
+    auto &ids = small.add_req_list<int>("IDS", "Identifiers.", std::span<int>(fixed));
+    auto two = std::array<char const *, 3>{"test", "7", "8"};
+    CHECK(small.parse(3, const_cast<char **>(two.data())));
+    CHECK_EQ(ids.get_values().size(), size_t(2));
+    CHECK_EQ(fixed[1], 8);
+    small.reset();
+    auto three = std::array<char const *, 4>{"test", "7", "8", "9"};
+    CHECK(!small.parse(4, const_cast<char **>(three.data())));
+}
+
+int main() {
+    test_lengths();
+    test_invalid();
+    test_limits();
+    test_lists();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+#include "argparse.hxx"
+#include "check.hxx"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <iterator>
+#include <string>
+
+static constexpr auto DESC =
+    std::string_view("A description that is long enough to be wrapped at least once or twice when the width is small.");
+static constexpr auto VERBOSE =
+    std::string_view("Verbosity flag with a description long enough to wrap with a hanging indent of its own.");
+
+// Length of the longest line of the message
+static auto longest_line(std::string_view s) -> size_t {
+    auto longest = size_t(0);
+    while (!s.empty()) {
+        auto len = std::min(s.find('\n'), s.size());
+        longest = std::max(longest, len);
+        s.remove_prefix(std::min(len + 1, s.size()));
+    }
+    return longest;
+}
+
+// Whether the words of the text are contained in order, independent of the line breaks
+static auto contains_words(std::string_view s, std::string_view text) -> bool {
+    auto strip = [](std::string_view v) {
+        auto out = std::string();
+        std::ranges::copy_if(v, std::back_inserter(out), [](char c) { return std::isspace(c) == 0; });
+        return out;
+    };
+    return strip(s).find(strip(text)) != std::string::npos;
+}
+
+// Column of the first character of `word`, and of the first character of the following line
+static auto columns_of(std::string_view s, std::string_view word) -> std::array<size_t, 2> {
+    auto at = s.find(word);
+    auto line = s.rfind('\n', at) + 1;
+    auto next = s.find('\n', at) + 1;
+    return {at - line, s.find_first_not_of(' ', next) - next};
+}
+
+// Descriptions and option descriptions are wrapped at word boundaries to the configured width
+static auto test_wrap() -> void {
+    auto parser = argparse::parser("test", DESC);
+    parser.add_opt_flag('v', "verbose", VERBOSE);
+    parser.add_opt_value<std::string_view>('o', "output", "Output path.");
+    auto &run = parser.add_command("run", DESC);
+    run.add_opt_flag('f', "force", VERBOSE);
+
+    parser.set_columns(60);
+    auto help = std::string();
+    parser.render_help(help);
+    CHECK(longest_line(help) <= 60);
+    CHECK(contains_words(help, DESC));
+    CHECK(contains_words(help, VERBOSE));
+    auto [first, next] = columns_of(help, "Verbosity");
+    CHECK(first > 0);
+    CHECK_EQ(first, next);
+
+    // Subcommands use the same width
+    auto sub = std::string();
+    run.render_help(sub);
+    CHECK(sub.find("Usage: test run ") != std::string::npos);
+    CHECK(longest_line(sub) <= 60);
+    CHECK(contains_words(sub, VERBOSE));
+
+    // Changing the width renders the messages again
+    parser.set_columns(200);
+    help.clear();
+    parser.render_help(help);
+    CHECK(help.find(DESC) != std::string::npos);
+    CHECK(help.find(VERBOSE) != std::string::npos);
+    sub.clear();
+    run.render_help(sub);
+    CHECK(sub.find(VERBOSE) != std::string::npos);
+}
+
+// Option descriptions keep at least 20 columns and words longer than a line are never split
+static auto test_narrow() -> void {
+    auto parser = argparse::parser("test", "Short supercalifragilisticexpialidocious words.");
+    parser.add_opt_flag('v', "verbose", VERBOSE);
+    parser.set_columns(20);
+    auto help = std::string();
+    parser.render_help(help);
+    CHECK(help.find("supercalifragilisticexpialidocious") != std::string::npos);
+    CHECK(help.find("Verbosity flag with") != std::string::npos);
+    CHECK(contains_words(help, VERBOSE));
+}
+
+// The buffer receives a prefix of the message, the complete length is returned in any case
+static auto test_buffer() -> void {
+    auto parser = argparse::parser("test", DESC);
+    parser.add_opt_flag('v', "verbose", VERBOSE);
+    parser.set_columns(60);
+    auto help = std::string();
+    parser.render_help(help);
+
+    CHECK_EQ(parser.render_help(std::span<char>()), help.size());
+    auto small = std::array<char, 16>{};
+    CHECK_EQ(parser.render_help(small), help.size());
+    CHECK_EQ(std::string_view(small.data(), small.size()), std::string_view(help).substr(0, small.size()));
+
+    auto large = std::string(help.size(), '\0');
+    CHECK_EQ(parser.render_help(std::span<char>(large)), help.size());
+    CHECK_EQ(large, help);
+}
+
+int main() {
+    test_wrap();
+    test_narrow();
+    test_buffer();
+    return failures == 0 ? 0 : 1;
+}
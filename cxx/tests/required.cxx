@@ -0,0 +1,95 @@
+#include "argparse.hxx"
+#include "check.hxx"
+
+#include <array>
+#include <stdexcept>
+
+// The references returned on creation read the values without any lookup
+static auto test_handles() -> void {
+    auto parser = argparse::parser("test", "Required.");
+    auto &count = parser.add_req_value<int>("COUNT", "Count.");
+    auto &names = parser.add_req_list<std::string_view>("NAMES", "Names.");
+
+    auto argv = std::array<char const *, 4>{"test", "3", "a", "b"};
+    CHECK(parser.parse(4, const_cast<char **>(argv.data())));
+    CHECK(count.get_value() != nullptr && *count.get_value() == 3);
+    CHECK_EQ(names.get_values().size(), size_t(2));
+    CHECK_EQ(names.get_values()[1], std::string_view("b"));
+
+    // The same arguments are found by name
+    CHECK(&parser.get_req_value<int>("COUNT") == &count);
+    CHECK(&parser.get_req_list<std::string_view>("NAMES") == &names);
+
+    parser.reset();
+    CHECK(count.get_value() == nullptr);
+    CHECK(names.get_values().empty());
+}
+
+// Lookups by name check the type, invalid definitions throw
+static auto test_definitions() -> void {
+    auto parser = argparse::parser("test", "Definitions.");
+    parser.add_req_value<int>("COUNT", "Count.");
+
+    auto threw = false;
+    try {
+        parser.get_req_value<long>("COUNT");
+    } catch (std::runtime_error const &) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    threw = false;
+    try {
+        parser.get_req_value<int>("MISSING");
+    } catch (std::runtime_error const &) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    threw = false;
+    try {
+        parser.add_req_value<int>("COUNT", "Duplicate.");
+    } catch (std::runtime_error const &) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    // A stream has to be the last required argument
+    auto streamed = argparse::parser("test", "Stream.");
+    streamed.add_req_stream<int>("IDS", "Identifiers.");
+    threw = false;
+    try {
+        streamed.add_req_value<int>("AFTER", "After the stream.");
+    } catch (std::runtime_error const &) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+// Missing and invalid values fail the run
+static auto test_failures() -> void {
+    auto parser = argparse::parser("test", "Failures.");
+    auto &first = parser.add_req_value<int>("FIRST", "First.");
+    auto &second = parser.add_req_value<double>("SECOND", "Second.");
+
+    auto missing = std::array<char const *, 2>{"test", "1"};
+    CHECK(!parser.parse(2, const_cast<char **>(missing.data())));
+    parser.reset();
+
+    auto invalid = std::array<char const *, 3>{"test", "1", "x"};
+    CHECK(!parser.parse(3, const_cast<char **>(invalid.data())));
+    CHECK(second.get_value() == nullptr);
+    parser.reset();
+
+    auto valid = std::array<char const *, 3>{"test", "1", "2.5"};
+    CHECK(parser.parse(3, const_cast<char **>(valid.data())));
+    CHECK(first.get_value() != nullptr && *first.get_value() == 1);
+    CHECK(second.get_value() != nullptr && *second.get_value() == 2.5);
+}
+
+int main() {
+    test_handles();
+    test_definitions();
+    test_failures();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+#include "argparse.hxx"
+#include "check.hxx"
+
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// File of the working directory holding the given content, removed on destruction
+class temp_file {
+  public:
+    explicit temp_file(std::string_view content) {
+        auto fd = mkstemp(_name.data());
+        CHECK(fd != -1);
+        if (fd != -1) {
+            CHECK(write(fd, content.data(), content.size()) == static_cast<ssize_t>(content.size()));
+            close(fd);
+        }
+    }
+    ~temp_file() { std::remove(_name.c_str()); }
+
+    auto name() const -> std::string const & { return _name; }
+    auto arg() const -> std::string { return "@" + _name; }
+
+  private:
+    std::string _name = "response-XXXXXX";
+};
+
+static auto expand(std::vector<std::string> args, size_t limit = 0) -> std::vector<std::string> {
+    auto argv = std::vector<char *>();
+    for (auto &a : args) {
+        argv.push_back(a.data());
+    }
+    auto expanded = argparse::response_args(static_cast<int>(argv.size()), argv.data(), limit);
+    auto out = std::vector<std::string>(expanded.argv(), expanded.argv() + expanded.argc());
+    CHECK(expanded.argv()[expanded.argc()] == nullptr);
+    return out;
+}
+
+static auto fails(std::vector<std::string> args, size_t limit = 0) -> bool {
+    try {
+        expand(std::move(args), limit);
+    } catch (std::runtime_error const &) {
+        return true;
+    }
+    return false;
+}
+
+// Whitespace separates, quotes and escapes are removed, the file itself stays unchanged
+static auto test_quoting() -> void {
+    auto content = std::string_view("plain  'single quoted' \"double \\\"quoted\\\"\"\n"
+                                    "es\\ caped \"a\\b\" 'it''s' mi\"x\"ed\t\\@literal \"@quoted\" '@single' @\n");
+    auto file = temp_file(content);
+    auto args = expand({"@app", "before", file.arg(), "after"});
+    auto expected = std::vector<std::string>{"@app",     "before", "plain", "single quoted", "double \"quoted\"",
+                                             "es caped", "a\\b",   "its",   "mixed",         "@literal",
+                                             "@quoted",  "@single", "@",    "after"};
+    CHECK(args == expected);
+
+    auto stream = std::ifstream(file.name());
+    auto buffer = std::stringstream();
+    buffer << stream.rdbuf();
+    CHECK_EQ(buffer.str(), std::string(content));
+}
+
+// The expanded arguments are parsed like argv of main and the values reference them
+static auto test_parse() -> void {
+    auto file = temp_file("-v --ids 1 2 3 -- 'a b'");
+    auto arg = file.arg();
+    auto argv = std::vector<char *>{const_cast<char *>("app"), arg.data()};
+    auto expanded = argparse::response_args(2, argv.data());
+
+    auto parser = argparse::parser("app", "Response.");
+    auto &verbose = parser.add_opt_flag('v', "verbose", "Verbosity.");
+    auto &ids = parser.add_opt_list<int>('i', "ids", "Identifiers.");
+    auto &name = parser.add_req_value<std::string_view>("NAME", "Name.");
+    auto res = argparse::result();
+    CHECK(parser.parse(expanded.argc(), expanded.argv(), res));
+    CHECK_EQ(res.cnt(verbose), size_t(1));
+    CHECK_EQ(res.get_values(ids).size(), size_t(3));
+    CHECK_EQ(res.get_value(name).value_or(""), std::string_view("a b"));
+    CHECK(res.get_value(name).value_or("").data() == expanded.argv()[7]);
+}
+
+// Response files may name further response files, the nesting depth is limited
+static auto test_nesting() -> void {
+    auto inner = temp_file("-v 'inner value'");
+    auto outer = temp_file("first " + inner.arg() + " last");
+    auto expected = std::vector<std::string>{"app", "first", "-v", "inner value", "last"};
+    CHECK(expand({"app", outer.arg()}) == expected);
+
+    // A file naming itself exceeds the depth, its name is only known once created
+    auto self = temp_file("");
+    std::ofstream(self.name()) << "x " << self.arg();
+    CHECK(fails({"app", self.arg()}));
+}
+
+// Missing files, unterminated quotes and files exceeding the limit fail the expansion
+static auto test_failures() -> void {
+    CHECK(fails({"app", "@response-missing"}));
+
+    auto unterminated = temp_file("a 'unterminated");
+    CHECK(fails({"app", unterminated.arg()}));
+
+    auto limited = temp_file("0123456789 0123456789");
+    CHECK(fails({"app", limited.arg()}, 10));
+    auto expected = std::vector<std::string>{"app", "0123456789", "0123456789"};
+    CHECK(expand({"app", limited.arg()}, 64) == expected);
+}
+
+// Lowest free descriptor, changes if a descriptor is left open
+static auto free_fd() -> int {
+    auto fd = dup(0);
+    close(fd);
+    return fd;
+}
+
+// Pipes are read instead of mapped, their descriptor is closed if the content exceeds the limit
+static auto test_pipe() -> void {
+    auto fds = std::array<int, 2>{-1, -1};
+    CHECK(pipe(fds.data()) == 0);
+    auto content = std::string(100, 'x');
+    CHECK(write(fds[1], content.data(), content.size()) == static_cast<ssize_t>(content.size()));
+    close(fds[1]);
+
+    auto arg = "@/dev/fd/" + std::to_string(fds[0]);
+    auto before = free_fd();
+    CHECK(fails({"app", arg}, 10));
+    CHECK_EQ(free_fd(), before);
+    close(fds[0]);
+}
+
+int main() {
+    test_quoting();
+    test_parse();
+    test_nesting();
+    test_failures();
+    test_pipe();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+#include "argparse.hxx"
+#include "check.hxx"
+
+#include <array>
+#include <thread>
+#include <vector>
+
+// Values are stored in the result, the parser itself stays untouched
+static auto test_values() -> void {
+    auto parser = argparse::parser("test", "Result.");
+    auto &verbose = parser.add_opt_flag('v', "verbose", "Verbosity.");
+    auto &output = parser.add_opt_value<std::string>('o', "output", "Output path.");
+    auto &list = parser.add_opt_list<int>('l', "list", "Values.");
+    auto &run = parser.add_command("run", "Run.");
+    auto &input = run.add_req_value<std::string_view>("INPUT", "Input path.");
+    auto &files = run.add_req_list<long>("FILES", "Files.");
+
+    auto res = argparse::result();
+    auto argv = std::array<char const *, 12>{"test", "-vv", "-o", "out", "-l", "1", "2", "run", "in", "7", "8", "9"};
+    CHECK(parser.parse(12, const_cast<char **>(argv.data()), res));
+    CHECK_EQ(res.cnt(verbose), size_t(2));
+    CHECK(res.is_set(verbose));
+    CHECK_EQ(res.get_value(output).value_or(""), std::string("out"));
+    CHECK(res.is_set(run));
+    CHECK_EQ(res.get_value(input).value_or(""), std::string_view("in"));
+
+    auto values = res.get_values(list);
+    CHECK_EQ(values.size(), size_t(2));
+    CHECK_EQ(values[0], 1);
+    CHECK_EQ(values[1], 2);
+    auto sum = 0L;
+    for (auto f : res.get_values(files)) {
+        sum += f;
+    }
+    CHECK_EQ(sum, 24L);
+
+    CHECK_EQ(verbose.cnt(), size_t(0));
+    CHECK(output.get_value() == nullptr);
+    CHECK(input.get_value() == nullptr);
+}
+
+// Each run clears the values of the previous one, results of the same parser are independent of each other
+static auto test_reuse() -> void {
+    auto parser = argparse::parser("test", "Reuse.");
+    auto &verbose = parser.add_opt_flag('v', "verbose", "Verbosity.");
+    auto &output = parser.add_opt_value<std::string_view>('o', "output", "Output path.");
+    auto &run = parser.add_command("run", "Run.");
+
+    auto first = argparse::result();
+    auto second = argparse::result();
+    auto full = std::array<char const *, 5>{"test", "-v", "-o", "out", "run"};
+    auto small = std::array<char const *, 2>{"test", "-vvv"};
+    for (auto i = 0; i < 3; ++i) {
+        CHECK(parser.parse(5, const_cast<char **>(full.data()), first));
+        CHECK(parser.parse(2, const_cast<char **>(small.data()), second));
+        CHECK_EQ(first.cnt(verbose), size_t(1));
+        CHECK(first.get_value(output).has_value());
+        CHECK(first.is_set(run));
+        CHECK_EQ(second.cnt(verbose), size_t(3));
+        CHECK(!second.get_value(output).has_value());
+        CHECK(!second.is_set(run));
+
+        CHECK(parser.parse(2, const_cast<char **>(small.data()), first));
+        CHECK_EQ(first.cnt(verbose), size_t(3));
+        CHECK(!first.get_value(output).has_value());
+        CHECK(!first.is_set(run));
+    }
+
+    // Parsing into the arguments themselves is independent of the results and cleared by reset()
+    CHECK(parser.parse(5, const_cast<char **>(full.data())));
+    CHECK_EQ(verbose.cnt(), size_t(1));
+    CHECK(output.get_value() != nullptr);
+    parser.reset();
+    CHECK_EQ(verbose.cnt(), size_t(0));
+    CHECK(output.get_value() == nullptr);
+    CHECK_EQ(second.cnt(verbose), size_t(3));
+}
+
+// Values are validated while parsing into a result, which stays usable after a failed run
+static auto test_invalid() -> void {
+    auto parser = argparse::parser("test", "Invalid.");
+    auto &list = parser.add_opt_list<int>('l', "list", "Values.");
+
+    auto res = argparse::result();
+    auto argv = std::array<char const *, 4>{"test", "-l", "1", "x"};
+    CHECK(!parser.parse(4, const_cast<char **>(argv.data()), res));
+    auto valid = std::array<char const *, 3>{"test", "-l", "5"};
+    CHECK(parser.parse(3, const_cast<char **>(valid.data()), res));
+    CHECK_EQ(res.get_values(list).size(), size_t(1));
+}
+
+// Any number of threads parse concurrently with one parser as long as each uses its own result
+static auto test_threads() -> void {
+    auto parser = argparse::parser("test", "Threads.");
+    auto &verbose = parser.add_opt_flag('v', "verbose", "Verbosity.");
+    auto &list = parser.add_opt_list<int>('l', "list", "Values.");
+
+    auto bundles = std::array<char const *, 4>{"-v", "-vv", "-vvv", "-vvvv"};
+    auto ok = std::array<bool, 4>{};
+    auto threads = std::vector<std::thread>();
+    for (auto t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            auto res = argparse::result();
+            auto argv = std::array<char const *, 4>{"test", bundles[t], "-l", "42"};
+            auto good = true;
+            for (auto i = 0; i < 1000; ++i) {
+                good = good && parser.parse(4, const_cast<char **>(argv.data()), res);
+                good = good && res.cnt(verbose) == size_t(t + 1) && res.get_values(list)[0] == 42;
+            }
+            ok[t] = good;
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    for (auto good : ok) {
+        CHECK(good);
+    }
+}
+
+int main() {
+    test_values();
+    test_reuse();
+    test_invalid();
+    test_threads();
+    return failures == 0 ? 0 : 1;
+}
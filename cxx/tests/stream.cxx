@@ -0,0 +1,106 @@
+#include "argparse.hxx"
+#include "check.hxx"
+
+#include <array>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Pipe whose read end provides the given content, small enough to fit into the pipe buffer
+static auto input(std::string_view content) -> int {
+    auto fds = std::array<int, 2>{-1, -1};
+    CHECK(pipe(fds.data()) == 0);
+    CHECK(write(fds[1], content.data(), content.size()) == static_cast<ssize_t>(content.size()));
+    close(fds[1]);
+    return fds[0];
+}
+
+// Values are converted one by one, either given on the commandline or read from the descriptor
+static auto test_read() -> void {
+    auto parser = argparse::parser("test", "Stream.");
+    auto &ids = parser.add_req_stream<int>("IDS", "Identifiers.");
+
+    auto none = std::array<char const *, 1>{"test"};
+    CHECK(parser.parse(1, const_cast<char **>(none.data())));
+    auto fd = input("1\n22\n\n333\n4444");
+    auto values = std::vector<int>();
+    CHECK(ids.read(fd, [&values](int id) { values.push_back(id); }));
+    CHECK((values == std::vector<int>{1, 22, 333, 4444}));
+    close(fd);
+    parser.reset();
+
+    auto dash = std::array<char const *, 2>{"test", "-"};
+    CHECK(parser.parse(2, const_cast<char **>(dash.data())));
+    fd = input(std::string_view("5\0" "6\0", 4));
+    values.clear();
+    CHECK(ids.read(fd, [&values](int id) { values.push_back(id); }, '\0'));
+    CHECK((values == std::vector<int>{5, 6}));
+    close(fd);
+    parser.reset();
+
+    // Values on the commandline are validated while parsing and delivered instead of reading the descriptor
+    auto given = std::array<char const *, 3>{"test", "7", "8"};
+    CHECK(parser.parse(3, const_cast<char **>(given.data())));
+    values.clear();
+    CHECK(ids.read(-1, [&values](int id) { values.push_back(id); }));
+    CHECK((values == std::vector<int>{7, 8}));
+    parser.reset();
+
+    auto invalid = std::array<char const *, 3>{"test", "7", "x"};
+    CHECK(!parser.parse(3, const_cast<char **>(invalid.data())));
+}
+
+// The callback stops by returning false, string views are only valid during the call
+static auto test_stop() -> void {
+    auto parser = argparse::parser("test", "Stream.");
+    auto &names = parser.add_req_stream<std::string_view>("NAMES", "Names.");
+
+    auto none = std::array<char const *, 1>{"test"};
+    CHECK(parser.parse(1, const_cast<char **>(none.data())));
+    auto fd = input("a\nb\nc\n");
+    auto joined = std::string();
+    CHECK(names.read(fd, [&joined](std::string_view name) {
+        joined.append(name);
+        return joined.size() < 2;
+    }));
+    CHECK_EQ(joined, std::string("ab"));
+    close(fd);
+}
+
+// Invalid values read from the descriptor fail, also when reading the values of a result
+static auto test_result() -> void {
+    auto parser = argparse::parser("test", "Stream.");
+    auto &ids = parser.add_req_stream<long>("IDS", "Identifiers.");
+    auto res = argparse::result();
+
+    auto given = std::array<char const *, 2>{"test", "9"};
+    CHECK(parser.parse(2, const_cast<char **>(given.data()), res));
+    auto sum = 0L;
+    CHECK(res.read(ids, -1, [&sum](long id) { sum += id; }));
+    CHECK_EQ(sum, 9L);
+
+    auto none = std::array<char const *, 1>{"test"};
+    CHECK(parser.parse(1, const_cast<char **>(none.data()), res));
+    auto fd = input("10\n20\n");
+    sum = 0;
+    CHECK(res.read(ids, fd, [&sum](long id) { sum += id; }));
+    CHECK_EQ(sum, 30L);
+    close(fd);
+
+    fd = input("1\nnope\n3\n");
+    sum = 0;
+    CHECK(!res.read(ids, fd, [&sum](long id) { sum += id; }));
+    CHECK_EQ(sum, 1L);
+    close(fd);
+
+    // The values given to the result aren't stored in the stream itself, thus it reads the unreadable descriptor
+    CHECK(parser.parse(2, const_cast<char **>(given.data()), res));
+    CHECK(!ids.read(-1, [](long) {}));
+}
+
+int main() {
+    test_read();
+    test_stop();
+    test_result();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+#include "argparse.hxx"
+#include "check.hxx"
+
+#include <array>
+
+// Classification and the number of consecutive words starting at each position
+static auto test_tokenize() -> void {
+    char const *const argv[] = {"test", "-", "--", "-v", "--verbose", "-h", "a", "b"};
+    auto tokens = argparse::tokenize(argv, 8);
+    CHECK_EQ(tokens.size(), size_t(8));
+    CHECK(tokens[1].kind == argparse::token_kind::word);
+    CHECK(tokens[2].kind == argparse::token_kind::separator);
+    CHECK(tokens[3].kind == argparse::token_kind::flag);
+    CHECK(tokens[4].kind == argparse::token_kind::flag);
+    CHECK(tokens[5].kind == argparse::token_kind::help);
+    CHECK_EQ(tokens[1].words, 1);
+    CHECK_EQ(tokens[3].words, 0);
+    CHECK_EQ(tokens[6].words, 2);
+    CHECK_EQ(tokens[7].words, 1);
+    CHECK_EQ(tokens[4].value, std::string_view("--verbose"));
+}
+
+// A single "-" is a plain word, e.g. the common name of stdin, and never a flag
+static auto test_lone_dash() -> void {
+    auto parser = argparse::parser("test", "Lone dash.");
+    auto &output = parser.add_opt_value<std::string_view>('o', "output", "Output path.");
+    auto &input = parser.add_req_value<std::string_view>("INPUT", "Input path.");
+
+    auto argv = std::array<char const *, 2>{"test", "-"};
+    CHECK(parser.parse(2, const_cast<char **>(argv.data())));
+    CHECK(input.get_value() != nullptr && *input.get_value() == "-");
+    CHECK(output.get_value() == nullptr);
+    parser.reset();
+
+    auto with_value = std::array<char const *, 4>{"test", "-o", "-", "-"};
+    CHECK(parser.parse(4, const_cast<char **>(with_value.data())));
+    CHECK(output.get_value() != nullptr && *output.get_value() == "-");
+    CHECK(input.get_value() != nullptr && *input.get_value() == "-");
+}
+
+// Combined short flags count each flag, a value list ends at the next flag or subcommand
+static auto test_boundaries() -> void {
+    auto parser = argparse::parser("test", "Boundaries.");
+    auto &verbose = parser.add_opt_flag('v', "verbose", "Verbosity.");
+    auto &list = parser.add_opt_list<int>('l', "list", "Values.");
+    auto &run = parser.add_command("run", "Run.");
+    auto &input = run.add_req_value<std::string_view>("INPUT", "Input path.");
+
+    auto argv = std::array<char const *, 10>{"test", "-vvv", "-l", "1", "2", "-v", "-l", "3", "run", "x"};
+    CHECK(parser.parse(10, const_cast<char **>(argv.data())));
+    CHECK_EQ(verbose.cnt(), size_t(4));
+    CHECK_EQ(list.get_values().size(), size_t(3));
+    CHECK_EQ(list.get_values().back(), 3);
+    CHECK(input.get_value() != nullptr && *input.get_value() == "x");
+}
+
+// Arguments following "--" are positional even if they look like flags
+static auto test_separator() -> void {
+    auto parser = argparse::parser("test", "Separator.");
+    auto &verbose = parser.add_opt_flag('v', "verbose", "Verbosity.");
+    auto &files = parser.add_req_list<std::string_view>("FILES", "Files.");
+
+    auto argv = std::array<char const *, 5>{"test", "-v", "--", "-v", "--verbose"};
+    CHECK(parser.parse(5, const_cast<char **>(argv.data())));
+    CHECK_EQ(verbose.cnt(), size_t(1));
+    CHECK_EQ(files.get_values().size(), size_t(2));
+    CHECK_EQ(files.get_values()[1], std::string_view("--verbose"));
+}
+
+int main() {
+    test_tokenize();
+    test_lone_dash();
+    test_boundaries();
+    test_separator();
+    return failures == 0 ? 0 : 1;
+}